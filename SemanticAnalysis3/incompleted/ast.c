@@ -0,0 +1,207 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ast.h"
+
+#define MIN_AST_CAPACITY 256
+#define SCRATCH_AST_CAPACITY 4096
+
+// capacity is a guess of the number of nodes. Every node stands for a
+// token of its own, so the number of tokens is a bound.
+Ast* createAst(int capacity) {
+  Ast *ast = (Ast*) malloc(sizeof(Ast));
+
+  if (capacity < MIN_AST_CAPACITY)
+    capacity = MIN_AST_CAPACITY;
+  ast->nodes = (Node*) malloc(capacity * sizeof(Node));
+  ast->count = 1;
+  ast->capacity = capacity;
+  ast->extra = (int*) malloc(capacity / 2 * sizeof(int));
+  ast->extraCount = 1;
+  ast->extraCapacity = capacity / 2;
+  ast->scratch = 0;
+  ast->base = 0;
+  return ast;
+}
+
+// For a parser that does not want the trees. The arena stays small and
+// in the cache: once full, it is reused from its first slot, so that
+// NodeIds stay valid indexes but old nodes are overwritten.
+Ast* createScratchAst(void) {
+  Ast *ast = createAst(SCRATCH_AST_CAPACITY);
+
+  ast->scratch = 1;
+  return ast;
+}
+
+// Takes the next slot of the arena for a construct at offset in the
+// source
+NodeId newNode(Ast *ast, enum NodeKind kind, int offset, int first, int second) {
+  NodeId id = ast->count ++;
+  Node *node;
+
+  if (id == ast->capacity) {
+    if (ast->scratch) {
+      id = 1;
+      ast->count = 2;
+    } else {
+      ast->capacity *= 2;
+      ast->nodes = (Node*) realloc(ast->nodes, ast->capacity * sizeof(Node));
+    }
+  }
+  node = &ast->nodes[id];
+  node->kind = kind;
+  node->op = 0;
+  node->offset = offset - ast->base;
+  node->first = first;
+  node->second = second;
+  return id;
+}
+
+// Reserves count ints of extra and returns the index of the first one
+int newExtra(Ast *ast, int count) {
+  int index = ast->extraCount;
+
+  ast->extraCount += count;
+  if (ast->extraCount > ast->extraCapacity) {
+    if (ast->scratch) {
+      index = 1;
+      ast->extraCount = 1 + count;
+      return index;
+    }
+    while (ast->extraCount > ast->extraCapacity)
+      ast->extraCapacity *= 2;
+    ast->extra = (int*) realloc(ast->extra, ast->extraCapacity * sizeof(int));
+  }
+  return index;
+}
+
+// Chains node after the cell *last, or starts the list when it is
+// empty. Empty statements come as NO_NODE and are left out.
+void appendNode(Ast *ast, int *list, int *last, NodeId node) {
+  int cell;
+
+  if (node == NO_NODE)
+    return;
+  cell = newExtra(ast, 2);
+  LIST_NODE(ast, cell) = node;
+  LIST_NEXT(ast, cell) = NO_LIST;
+  if (*list == NO_LIST)
+    *list = cell;
+  else LIST_NEXT(ast, *last) = cell;
+  *last = cell;
+}
+
+// What appendAst() adds to the indexes of the tree it moves
+struct Shift {
+  int nodes;
+  int extra;
+  int firstObject;
+  int objects;
+};
+
+#define SHIFT_NODE(shift, id) (((id) == NO_NODE) ? NO_NODE : (id) + (shift)->nodes)
+#define SHIFT_OBJECT(shift, index) (((index) >= (shift)->firstObject) ? (index) + (shift)->objects : (index))
+
+// list is the index of the first moved cell before the move
+int shiftList(Ast *ast, struct Shift *shift, int list) {
+  int cell;
+
+  if (list == NO_LIST)
+    return NO_LIST;
+  list += shift->extra;
+  for (cell = list; ; cell = LIST_NEXT(ast, cell)) {
+    LIST_NODE(ast, cell) = SHIFT_NODE(shift, LIST_NODE(ast, cell));
+    if (LIST_NEXT(ast, cell) == NO_LIST)
+      break;
+    LIST_NEXT(ast, cell) += shift->extra;
+  }
+  return list;
+}
+
+// Fixes the indexes in a moved node and in the extra it owns
+void shiftNode(Ast *ast, struct Shift *shift, Node *node) {
+  int i;
+
+  switch (node->kind) {
+  case N_ASSIGN:
+  case N_WHILE:
+  case N_INDEX:
+  case N_BINARY:
+  case N_CONDITION:
+    node->first = SHIFT_NODE(shift, node->first);
+    node->second = SHIFT_NODE(shift, node->second);
+    break;
+  case N_NEGATE:
+    node->first = SHIFT_NODE(shift, node->first);
+    break;
+  case N_CALL:
+  case N_FUNCTION:
+    node->first = SHIFT_OBJECT(shift, node->first);
+    node->second = shiftList(ast, shift, node->second);
+    break;
+  case N_GROUP:
+    node->first = shiftList(ast, shift, node->first);
+    break;
+  case N_IF:
+    node->first = SHIFT_NODE(shift, node->first);
+    node->second += shift->extra;
+    for (i = 0; i < 2; i++)
+      ast->extra[node->second + i] = SHIFT_NODE(shift, ast->extra[node->second + i]);
+    break;
+  case N_FOR:
+    node->first = SHIFT_OBJECT(shift, node->first);
+    node->second += shift->extra;
+    for (i = 0; i < 3; i++)
+      ast->extra[node->second + i] = SHIFT_NODE(shift, ast->extra[node->second + i]);
+    break;
+  case N_CONSTANT:
+  case N_VARIABLE:
+  case N_PARAMETER:
+    node->first = SHIFT_OBJECT(shift, node->first);
+    break;
+  default:
+    break;
+  }
+}
+
+// Moves the nodes of from to the end of to, where their indexes change:
+// the NodeIds of from must be added the returned shift. The objects of
+// from numbered firstObject or more are renumbered by objectShift.
+int appendAst(Ast *to, Ast *from, int firstObject, int objectShift) {
+  struct Shift shift;
+  int nodeCount = from->count - 1, extraCount = from->extraCount - 1;
+  int i;
+
+  shift.nodes = to->count - 1;
+  shift.extra = to->extraCount - 1;
+  shift.firstObject = firstObject;
+  shift.objects = objectShift;
+
+  if (to->count + nodeCount > to->capacity) {
+    while (to->count + nodeCount > to->capacity)
+      to->capacity *= 2;
+    to->nodes = (Node*) realloc(to->nodes, to->capacity * sizeof(Node));
+  }
+  memcpy(to->nodes + to->count, from->nodes + 1, nodeCount * sizeof(Node));
+  newExtra(to, extraCount);
+  memcpy(to->extra + shift.extra + 1, from->extra + 1, extraCount * sizeof(int));
+
+  for (i = to->count; i < to->count + nodeCount; i++)
+    shiftNode(to, &shift, &to->nodes[i]);
+  to->count += nodeCount;
+  return shift.nodes;
+}
+
+void freeAst(Ast *ast) {
+  if (ast == NULL)
+    return;
+  free(ast->nodes);
+  free(ast->extra);
+  free(ast);
+}
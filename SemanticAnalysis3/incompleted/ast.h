@@ -0,0 +1,101 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __AST_H__
+#define __AST_H__
+
+// The statement parts of a program as a tree. Declarations are not in
+// the tree: they are the objects of the symbol table, which the tree
+// refers to by their index in the object table. Nodes live in one array,
+// the arena, and refer to each other by index. What does not fit in a
+// node, the lists and a third child, goes to a second array of ints,
+// extra. Both only grow at their end and are released in one go with
+// the whole tree.
+
+// An index into the arena. The first slot is never used, so that
+// NO_NODE can stand for an absent child. A list is an index into extra,
+// NO_LIST when it is empty.
+typedef int NodeId;
+
+#define NO_NODE 0
+#define NO_LIST 0
+
+enum NodeKind {
+  // Statements. An empty statement has no node.
+  N_ASSIGN,       // first := second
+  N_CALL,         // CALL object first(list second)
+  N_GROUP,        // BEGIN list first END
+  N_IF,           // IF first THEN extra[second] ELSE extra[second + 1]
+  N_WHILE,        // WHILE first DO second
+  N_FOR,          // FOR object first := extra[second] TO extra[second + 1]
+                  // DO extra[second + 2]
+
+  // Expressions
+  N_NUMBER,       // the value first
+  N_CHAR,         // the value first
+  N_CONSTANT,     // object first
+  N_VARIABLE,     // object first
+  N_PARAMETER,    // object first
+  N_FUNCTION,     // object first(list second); the result of the
+                  // function when it is the left side of an assignment
+  N_INDEX,        // first(.second.)
+  N_NEGATE,       // -first
+  N_BINARY,       // first op second, op is one of + - * /
+  N_CONDITION     // first op second, op is a comparison
+};
+
+// 16 bytes. op is the operator token of N_BINARY and N_CONDITION and
+// offset is where the construct starts in the source, from the BEGIN of
+// the statement part it is in. Then a statement part that moves in the
+// source, because of an edit before it, has nothing to update but where
+// it starts, which the symbol table keeps with its tree.
+struct Node_ {
+  unsigned char kind;
+  unsigned char op;
+  int offset;
+  int first;
+  int second;
+};
+
+typedef struct Node_ Node;
+
+// A scratch tree starts over at its first slots when it is full instead
+// of growing, see createScratchAst(). base is the offset of the BEGIN of
+// the statement part being built.
+struct Ast_ {
+  Node *nodes;
+  int count;
+  int capacity;
+  int *extra;
+  int extraCount;
+  int extraCapacity;
+  int scratch;
+  int base;
+};
+
+typedef struct Ast_ Ast;
+
+// Nodes may move when the arena grows, so pointers from NODE() are only
+// good until the next newNode()
+#define NODE(ast, id) (&(ast)->nodes[id])
+
+// Where a node of the statement part being built starts in the source
+#define SOURCE_OFFSET(ast, id) (NODE(ast, id)->offset + (ast)->base)
+
+// A list is a chain of cells of two ints in extra: the node and the next
+// cell
+#define LIST_NODE(ast, list) ((ast)->extra[list])
+#define LIST_NEXT(ast, list) ((ast)->extra[(list) + 1])
+
+Ast* createAst(int capacity);
+Ast* createScratchAst(void);
+NodeId newNode(Ast *ast, enum NodeKind kind, int offset, int first, int second);
+int newExtra(Ast *ast, int count);
+void appendNode(Ast *ast, int *list, int *last, NodeId node);
+int appendAst(Ast *to, Ast *from, int firstObject, int objectShift);
+void freeAst(Ast *ast);
+
+#endif
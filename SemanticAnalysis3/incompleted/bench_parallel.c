@@ -0,0 +1,102 @@
+/* Parallel scanner benchmark
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Pretokenizes whole files on 1 to 16 threads, checks that every run
+// gives the token stream of the sequential scanner and reports the
+// throughput and the speedup over one thread.
+// usage: bench_parallel [-n repeat] [--dfa] file...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "reader.h"
+#include "tokenbuffer.h"
+#include "parallelscan.h"
+
+#define DEFAULT_REPEAT 20
+#define MAX_THREADS 16
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int sameBuffers(TokenBuffer *a, TokenBuffer *b) {
+  return (a->count == b->count) &&
+    (memcmp(a->types, b->types, a->count * sizeof(unsigned char)) == 0) &&
+    (memcmp(a->offsets, b->offsets, a->count * sizeof(int)) == 0) &&
+    (memcmp(a->lengths, b->lengths, a->count * sizeof(int)) == 0) &&
+    (memcmp(a->values, b->values, a->count * sizeof(int)) == 0);
+}
+
+void rewindInput(KplContext *ctx) {
+  ctx->inputPtr = ctx->inputBuffer;
+  readChar(ctx);
+}
+
+int main(int argc, char *argv[]) {
+  int repeat = DEFAULT_REPEAT;
+  int dfa = 0;
+  int i, r, threads;
+
+  for (i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+      repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--dfa") == 0)
+      dfa = 1;
+    else break;
+  }
+  if (i >= argc) {
+    printf("usage: bench_parallel [-n repeat] [--dfa] file...\n");
+    return -1;
+  }
+
+  for (; i < argc; i++) {
+    KplContext *ctx = createContext();
+    TokenBuffer *expected, *actual;
+    double size, start, elapsed, single = 0;
+
+    ctx->dfaScanner = dfa;
+    if (openInputStream(ctx, argv[i]) == IO_ERROR) {
+      printf("%s: can't read\n", argv[i]);
+      freeContext(ctx);
+      continue;
+    }
+    size = ctx->inputEnd - ctx->inputBuffer;
+    expected = tokenizeInput(ctx);
+    printf("%s: %.0f bytes, %d tokens\n", argv[i], size, expected->count);
+    printf("%8s %12s %8s\n", "threads", "throughput", "speedup");
+
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+      rewindInput(ctx);
+      actual = tokenizeInputParallel(ctx, threads);
+      if (!sameBuffers(expected, actual)) {
+	printf("%8d MISMATCH with the sequential scanner\n", threads);
+	freeTokenBuffer(actual);
+	continue;
+      }
+      freeTokenBuffer(actual);
+
+      start = now();
+      for (r = 0; r < repeat; r++) {
+	rewindInput(ctx);
+	freeTokenBuffer(tokenizeInputParallel(ctx, threads));
+      }
+      elapsed = now() - start;
+      if (threads == 1)
+	single = elapsed;
+      printf("%8d %7.1f MB/s %7.2fx\n", threads, size * repeat / elapsed / 1e6, single / elapsed);
+    }
+
+    freeTokenBuffer(expected);
+    closeInputStream(ctx);
+    freeContext(ctx);
+  }
+  return 0;
+}
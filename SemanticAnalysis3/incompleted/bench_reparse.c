@@ -0,0 +1,287 @@
+/* Incremental reparsing benchmark
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Opens a program and edits it at random, as someone typing would: a
+// number is changed or becomes a sum, a blank is put in, or a token is
+// broken and mended again by the next edit. Reports the latency of
+// reparseEdit() for each thing it had to do. With --check, the state
+// after every edit is checked against the whole edited text compiled
+// again: diagnostics, token ranges, objects and trees, offsets included.
+// usage: bench_reparse [-n edits] [-s seed] [--check] file
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "reader.h"
+#include "tokenbuffer.h"
+#include "symtab.h"
+#include "ast.h"
+#include "error.h"
+#include "parser.h"
+#include "incremental.h"
+
+#define DEFAULT_EDITS 1000
+#define KIND_COUNT 3
+
+char *kindNames[KIND_COUNT] = {"nothing", "body", "program"};
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int sameNodes(KplContext *a, NodeId x, KplContext *b, NodeId y);
+
+int sameObjectRefs(KplContext *a, int x, KplContext *b, int y) {
+  return strcmp(OBJECT(a->symtab, x)->name, OBJECT(b->symtab, y)->name) == 0;
+}
+
+int sameLists(KplContext *a, int x, KplContext *b, int y) {
+  for (; (x != NO_LIST) && (y != NO_LIST); x = LIST_NEXT(a->ast, x), y = LIST_NEXT(b->ast, y))
+    if (!sameNodes(a, LIST_NODE(a->ast, x), b, LIST_NODE(b->ast, y)))
+      return 0;
+  return (x == NO_LIST) && (y == NO_LIST);
+}
+
+int sameNodes(KplContext *a, NodeId x, KplContext *b, NodeId y) {
+  Node *m, *n;
+  int i;
+
+  if ((x == NO_NODE) || (y == NO_NODE))
+    return x == y;
+  m = NODE(a->ast, x);
+  n = NODE(b->ast, y);
+  if ((m->kind != n->kind) || (m->op != n->op) || (m->offset != n->offset))
+    return 0;
+
+  switch (m->kind) {
+  case N_NUMBER:
+  case N_CHAR:
+    return m->first == n->first;
+  case N_CONSTANT:
+  case N_VARIABLE:
+  case N_PARAMETER:
+    return sameObjectRefs(a, m->first, b, n->first);
+  case N_FUNCTION:
+  case N_CALL:
+    return sameObjectRefs(a, m->first, b, n->first) && sameLists(a, m->second, b, n->second);
+  case N_GROUP:
+    return sameLists(a, m->first, b, n->first);
+  case N_NEGATE:
+    return sameNodes(a, m->first, b, n->first);
+  case N_IF:
+    return sameNodes(a, m->first, b, n->first) &&
+      sameNodes(a, a->ast->extra[m->second], b, b->ast->extra[n->second]) &&
+      sameNodes(a, a->ast->extra[m->second + 1], b, b->ast->extra[n->second + 1]);
+  case N_FOR:
+    if (!sameObjectRefs(a, m->first, b, n->first))
+      return 0;
+    for (i = 0; i < 3; i++)
+      if (!sameNodes(a, a->ast->extra[m->second + i], b, b->ast->extra[n->second + i]))
+	return 0;
+    return 1;
+  default:
+    return sameNodes(a, m->first, b, n->first) && sameNodes(a, m->second, b, n->second);
+  }
+}
+
+// Trees with where their statement part starts
+int sameBodies(KplContext *a, NodeId x, int xOffset, KplContext *b, NodeId y, int yOffset) {
+  return sameNodes(a, x, b, y) && ((x == NO_NODE) || (xOffset == yOffset));
+}
+
+int sameObjects(KplContext *a, Object *x, KplContext *b, Object *y) {
+  ObjectNode *list, *other;
+
+  if ((x->kind != y->kind) || (strcmp(x->name, y->name) != 0))
+    return 0;
+
+  switch (x->kind) {
+  case OBJ_FUNCTION:
+    if ((x->funcAttrs->firstToken != y->funcAttrs->firstToken) ||
+	(x->funcAttrs->lastToken != y->funcAttrs->lastToken) ||
+	(x->funcAttrs->pending != y->funcAttrs->pending) ||
+	!sameBodies(a, x->funcAttrs->body, x->funcAttrs->bodyOffset, b, y->funcAttrs->body, y->funcAttrs->bodyOffset))
+      return 0;
+    list = x->funcAttrs->scope->objList;
+    other = y->funcAttrs->scope->objList;
+    break;
+  case OBJ_PROCEDURE:
+    if ((x->procAttrs->firstToken != y->procAttrs->firstToken) ||
+	(x->procAttrs->lastToken != y->procAttrs->lastToken) ||
+	(x->procAttrs->pending != y->procAttrs->pending) ||
+	!sameBodies(a, x->procAttrs->body, x->procAttrs->bodyOffset, b, y->procAttrs->body, y->procAttrs->bodyOffset))
+      return 0;
+    list = x->procAttrs->scope->objList;
+    other = y->procAttrs->scope->objList;
+    break;
+  case OBJ_PROGRAM:
+    if (!sameBodies(a, x->progAttrs->body, x->progAttrs->bodyOffset, b, y->progAttrs->body, y->progAttrs->bodyOffset))
+      return 0;
+    list = x->progAttrs->scope->objList;
+    other = y->progAttrs->scope->objList;
+    break;
+  default:
+    return 1;
+  }
+
+  for (; (list != NULL) && (other != NULL); list = list->next, other = other->next)
+    if (!sameObjects(a, list->object, b, other->object))
+      return 0;
+  return (list == NULL) && (other == NULL);
+}
+
+int samePrograms(KplContext *a, KplContext *b) {
+  int i;
+
+  if ((a->parseIncomplete != b->parseIncomplete) || (a->diagnosticCount != b->diagnosticCount))
+    return 0;
+  for (i = 0; i < a->diagnosticCount; i++)
+    if ((a->diagnostics[i].errorCode != b->diagnostics[i].errorCode) ||
+	(a->diagnostics[i].missing != b->diagnostics[i].missing) ||
+	(a->diagnostics[i].offset != b->diagnostics[i].offset))
+      return 0;
+  if ((a->symtab->program == NULL) || (b->symtab->program == NULL))
+    return a->symtab->program == b->symtab->program;
+  return sameObjects(a, a->symtab->program, b, b->symtab->program);
+}
+
+// Compiles the edited input of ctx again from scratch
+int checkEdit(KplContext *ctx) {
+  char fileName[] = "/tmp/bench_reparseXXXXXX";
+  int fd = mkstemp(fileName);
+  KplContext *fresh = createContext();
+  int same = 0;
+
+  if ((fd >= 0) && (write(fd, ctx->inputBuffer, ctx->inputEnd - ctx->inputBuffer) == ctx->inputEnd - ctx->inputBuffer)) {
+    fresh->preTokenize = 1;
+    fresh->maxErrors = ctx->maxErrors;
+    if (openProgram(fresh, fileName) == IO_SUCCESS) {
+      same = samePrograms(ctx, fresh);
+      closeProgram(fresh);
+    }
+  }
+  if (fd >= 0) {
+    close(fd);
+    unlink(fileName);
+  }
+  freeContext(fresh);
+  return same;
+}
+
+// Picks the next edit: start, removed and the text put there. A broken
+// token is mended by the edit after it.
+void nextEdit(KplContext *ctx, int *start, int *removed, char *text, int *broken) {
+  TokenBuffer *tokens = ctx->tokens;
+  int i = (tokens->count > 1) ? rand() % (tokens->count - 1) : 0;
+
+  *removed = 0;
+  if (*broken >= 0) {
+    *start = *broken;
+    *removed = 1;
+    text[0] = '\0';
+    *broken = -1;
+    return;
+  }
+
+  *start = tokens->offsets[i];
+  switch (rand() % 10) {
+  case 0:
+    strcpy(text, "+");
+    *broken = *start;
+    break;
+  case 1:
+  case 2:
+  case 3:
+    strcpy(text, " ");
+    break;
+  default:
+    // A number somewhere after the token
+    while ((i < tokens->count - 1) && (tokens->types[i] != TK_NUMBER))
+      i ++;
+    if (tokens->types[i] != TK_NUMBER) {
+      strcpy(text, " ");
+      break;
+    }
+    *start = tokens->offsets[i];
+    *removed = tokens->lengths[i];
+    // Not where a declaration wants a constant
+    if ((rand() % 2) || (tokens->types[i - 1] == SB_EQ) || (tokens->types[i - 1] == SB_LSEL))
+      sprintf(text, "%d", rand() % 1000);
+    else sprintf(text, "%d+%d", rand() % 1000, rand() % 1000);
+    break;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int edits = DEFAULT_EDITS;
+  int seed = 1;
+  int check = 0;
+  KplContext *ctx;
+  double start, elapsed, total[KIND_COUNT] = {0}, worst[KIND_COUNT] = {0};
+  int count[KIND_COUNT] = {0};
+  int i, at, removed, broken = -1, mismatches = 0;
+  ReparseKind kind;
+  char text[16];
+
+  for (i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+      edits = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+      seed = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--check") == 0)
+      check = 1;
+    else break;
+  }
+  if (i != argc - 1) {
+    printf("usage: bench_reparse [-n edits] [-s seed] [--check] file\n");
+    return -1;
+  }
+
+  ctx = createContext();
+  ctx->preTokenize = 1;
+  start = now();
+  if (openProgram(ctx, argv[i]) == IO_ERROR) {
+    printf("%s: can't read\n", argv[i]);
+    freeContext(ctx);
+    return -1;
+  }
+  printf("%s: %d lines, %d tokens, parsed in %.1f ms\n", argv[i], ctx->lineCount, ctx->tokens->count, (now() - start) * 1e3);
+
+  srand(seed);
+  for (i = 0; i < edits; i++) {
+    nextEdit(ctx, &at, &removed, text, &broken);
+    start = now();
+    if (reparseEdit(ctx, at, removed, text, strlen(text), &kind) == IO_ERROR) {
+      printf("edit %d: can't edit\n", i);
+      break;
+    }
+    elapsed = now() - start;
+    count[kind] ++;
+    total[kind] += elapsed;
+    if (elapsed > worst[kind])
+      worst[kind] = elapsed;
+    if (check && !checkEdit(ctx)) {
+      printf("edit %d at %d: MISMATCH with the whole program compiled again\n", i, at);
+      mismatches ++;
+    }
+  }
+
+  printf("%8s %8s %10s %10s\n", "reparse", "edits", "mean", "worst");
+  for (i = 0; i < KIND_COUNT; i++)
+    if (count[i] > 0)
+      printf("%8s %8d %7.3f ms %7.3f ms\n", kindNames[i], count[i], total[i] / count[i] * 1e3, worst[i] * 1e3);
+  if (check)
+    printf("%d mismatches\n", mismatches);
+
+  closeProgram(ctx);
+  freeContext(ctx);
+  return (mismatches > 0) ? 1 : 0;
+}
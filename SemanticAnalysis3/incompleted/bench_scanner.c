@@ -0,0 +1,286 @@
+/* Scanner benchmark
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Runs the scanner engines over whole files held in memory and checks
+// that they produce the same token stream. For every input it reports
+// the throughput of each engine in MB/s, tokens/s and ns/token, the
+// number of malloc calls made over all the timed passes, and what the
+// input is made of: tokens and source bytes per token class. The program
+// is linked with --wrap=malloc so that every call goes through
+// __wrap_malloc below.
+//
+// With -s size, synthetic inputs of about size bytes are generated and
+// measured after the files: typical statements, long comments and deep
+// indentation, long identifiers, and dense numbers and operators.
+//
+// usage: bench_scanner [-n repeat] [-s size] file...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "reader.h"
+#include "scanner.h"
+
+#define DEFAULT_REPEAT 200
+#define SYNTHETIC_TOTAL_BYTES 1e8
+
+typedef Token (*ScanFunction)(KplContext *ctx);
+
+enum TokenClass {
+  CLASS_IDENT,
+  CLASS_KEYWORD,
+  CLASS_NUMBER,
+  CLASS_CHAR,
+  CLASS_SYMBOL,
+  CLASS_EOF,
+  CLASS_COUNT
+};
+
+char *classNames[CLASS_COUNT] = {
+  "identifier", "keyword", "number", "char", "symbol", "eof"
+};
+
+struct Engine {
+  char *name;
+  ScanFunction scan;
+};
+
+struct Engine engines[] = {
+  { "getToken", getToken },
+  { "getTokenDfa", getTokenDfa }
+};
+
+#define ENGINE_COUNT 2
+
+long mallocCount = 0;
+
+void* __real_malloc(size_t size);
+
+void* __wrap_malloc(size_t size) {
+  mallocCount ++;
+  return __real_malloc(size);
+}
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+enum TokenClass classOf(TokenType tokenType) {
+  if (tokenType == TK_IDENT) return CLASS_IDENT;
+  if (tokenType == TK_NUMBER) return CLASS_NUMBER;
+  if (tokenType == TK_CHAR) return CLASS_CHAR;
+  if (tokenType == TK_EOF) return CLASS_EOF;
+  if (tokenType < SB_SEMICOLON) return CLASS_KEYWORD;
+  return CLASS_SYMBOL;
+}
+
+void rewindInput(KplContext *ctx) {
+  ctx->inputPtr = ctx->inputBuffer;
+  readChar(ctx);
+}
+
+// Scans the whole input once and returns the number of tokens
+long scanAll(KplContext *ctx, ScanFunction scan) {
+  long count = 0;
+  Token token;
+
+  rewindInput(ctx);
+  do {
+    token = scan(ctx);
+    count ++;
+  } while (token.tokenType != TK_EOF);
+  return count;
+}
+
+// Checks the engines against each other and counts the tokens and the
+// bytes of every class
+int sameStreams(KplContext *ctx, long *tokens, long *bytes) {
+  KplContext dfa = *ctx;
+  Token expected, actual;
+  int length, same = 1;
+
+  rewindInput(ctx);
+  rewindInput(&dfa);
+  do {
+    expected = getToken(ctx);
+    actual = getTokenDfa(&dfa);
+    length = scannedLength(ctx, expected);
+    if ((expected.tokenType != actual.tokenType) || (expected.offset != actual.offset) ||
+	(length != scannedLength(&dfa, actual)) || (expected.value != actual.value))
+      same = 0;
+    tokens[classOf(expected.tokenType)] ++;
+    bytes[classOf(expected.tokenType)] += length;
+  } while (same && (expected.tokenType != TK_EOF));
+  return same;
+}
+
+double timeEngine(KplContext *ctx, ScanFunction scan, int repeat, long *tokens, long *mallocs) {
+  double start;
+  int i;
+
+  *mallocs = mallocCount;
+  start = now();
+  for (i = 0; i < repeat; i++)
+    *tokens = scanAll(ctx, scan);
+  start = now() - start;
+  *mallocs = mallocCount - *mallocs;
+  return start;
+}
+
+/******************************************************************/
+
+double totalBytes = 0;
+double totalTime[ENGINE_COUNT];
+long totalTokens = 0;
+
+// title names the input in the report
+void benchFile(char *fileName, char *title, int repeat) {
+  KplContext *ctx = createContext();
+  long tokens[CLASS_COUNT], bytes[CLASS_COUNT];
+  long count = 0, mallocs;
+  double size, t;
+  int i;
+
+  if (openInputStream(ctx, fileName) == IO_ERROR) {
+    printf("%s: can't read\n\n", title);
+    freeContext(ctx);
+    return;
+  }
+  size = ctx->inputEnd - ctx->inputBuffer;
+  memset(tokens, 0, sizeof(tokens));
+  memset(bytes, 0, sizeof(bytes));
+
+  if (setjmp(ctx->errorJump) != 0) {
+    printf("%s: skipped, lexical error\n\n", title);
+  } else if (!sameStreams(ctx, tokens, bytes)) {
+    printf("%s: MISMATCH between engines\n\n", title);
+  } else {
+    for (i = 0; i < CLASS_COUNT; i++)
+      count += tokens[i];
+    printf("%s: %.0f bytes, %ld tokens, %d passes\n", title, size, count, repeat);
+    printf("  %-12s %10s %10s %10s %8s\n", "engine", "MB/s", "Mtokens/s", "ns/token", "mallocs");
+    for (i = 0; i < ENGINE_COUNT; i++) {
+      t = timeEngine(ctx, engines[i].scan, repeat, &count, &mallocs);
+      printf("  %-12s %10.1f %10.2f %10.1f %8ld\n", engines[i].name,
+	     size * repeat / t / 1e6, count * repeat / t / 1e6, t * 1e9 / (count * repeat), mallocs);
+      totalTime[i] += t;
+    }
+    printf("  %-12s %10s %7s %10s %7s\n", "class", "tokens", "%", "bytes", "%");
+    for (i = 0; i < CLASS_COUNT; i++)
+      printf("  %-12s %10ld %6.1f%% %10ld %6.1f%%\n", classNames[i],
+	     tokens[i], 100.0 * tokens[i] / count, bytes[i], 100.0 * bytes[i] / size);
+    printf("\n");
+    totalBytes += size * repeat;
+    totalTokens += count * repeat;
+  }
+
+  closeInputStream(ctx);
+  freeContext(ctx);
+}
+
+/******************************************************************/
+
+// Synthetic inputs. They are scanned, not parsed, so only the mix of
+// lexemes matters.
+
+void writeTypical(FILE *f, int i) {
+  fprintf(f, "  IF X%d <= %d THEN Y := Y + X%d * 2 ELSE CALL WRITEI(Y); (* step %d *)\n",
+	  i % 97, i, i % 13, i);
+}
+
+void writeComments(FILE *f, int i) {
+  fprintf(f, "(**************************************************************\n"
+	  " * block %-8d                                               *\n"
+	  " **************************************************************)\n"
+	  "                                        X := %d;\n", i, i);
+}
+
+void writeIdentifiers(FILE *f, int i) {
+  fprintf(f, "  ACCUMULATOR%04d := COUNTERVALUE%03d + RUNNINGTOTALX%02d;\n",
+	  i % 10000, i % 1000, i % 100);
+}
+
+void writeNumbers(FILE *f, int i) {
+  fprintf(f, "  A(.%d.) := (%d+%d)*%d/%d-'%c';\n",
+	  i % 100, i, 2 * i + 1, i % 7, i % 9 + 1, 'a' + i % 26);
+}
+
+struct Shape {
+  char *name;
+  void (*write)(FILE *f, int i);
+};
+
+struct Shape shapes[] = {
+  { "typical", writeTypical },
+  { "comments", writeComments },
+  { "identifiers", writeIdentifiers },
+  { "numbers", writeNumbers }
+};
+
+#define SHAPE_COUNT 4
+
+void benchSynthetic(long size, int repeat) {
+  char fileName[64], title[64];
+  FILE *f;
+  int shape, fd, i;
+
+  for (shape = 0; shape < SHAPE_COUNT; shape++) {
+    sprintf(fileName, "/tmp/bench_scanner_XXXXXX");
+    fd = mkstemp(fileName);
+    if ((fd < 0) || ((f = fdopen(fd, "w")) == NULL)) {
+      printf("synthetic %s: can't create a temporary file\n\n", shapes[shape].name);
+      continue;
+    }
+    fprintf(f, "PROGRAM SYNTHETIC;\nBEGIN\n");
+    for (i = 0; ftell(f) < size; i++)
+      shapes[shape].write(f, i);
+    fprintf(f, "END.\n");
+    fclose(f);
+
+    sprintf(title, "synthetic %s", shapes[shape].name);
+    benchFile(fileName, title, repeat);
+    unlink(fileName);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int repeat = DEFAULT_REPEAT;
+  long synthetic = 0;
+  int i;
+
+  for (i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-n") == 0)
+      repeat = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "-s") == 0)
+      synthetic = atol(argv[i + 1]);
+    else break;
+  }
+  if ((i >= argc) && (synthetic == 0)) {
+    printf("usage: bench_scanner [-n repeat] [-s size] file...\n");
+    return -1;
+  }
+
+  for (; i < argc; i++)
+    benchFile(argv[i], argv[i], repeat);
+  // Big inputs get fewer passes, about SYNTHETIC_TOTAL_BYTES per engine
+  if (synthetic > 0) {
+    int passes = (int) (SYNTHETIC_TOTAL_BYTES / synthetic);
+    benchSynthetic(synthetic, (passes < repeat) ? ((passes > 0) ? passes : 1) : repeat);
+  }
+
+  if (totalBytes > 0) {
+    printf("total: %.0f bytes, %ld tokens\n", totalBytes, totalTokens);
+    for (i = 0; i < ENGINE_COUNT; i++)
+      printf("  %-12s %10.1f %10.2f %10.1f\n", engines[i].name, totalBytes / totalTime[i] / 1e6,
+	     totalTokens / totalTime[i] / 1e6, totalTime[i] * 1e9 / totalTokens);
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+/* Table-driven parser benchmark
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Parses pretokenized files again and again with the recursive descent
+// parser and with the LL(1) table, with the symbol table and in
+// syntax-only mode, checks that both give the same trees, objects and
+// diagnostics and reports their throughput. With -d, a program with its
+// statements nested depth levels deep is parsed by each of them in a
+// process of its own, since recursive descent may run out of stack.
+// usage: bench_table [-n repeat] [-d depth] file...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "reader.h"
+#include "tokenbuffer.h"
+#include "symtab.h"
+#include "ast.h"
+#include "error.h"
+#include "parser.h"
+
+#define DEFAULT_REPEAT 20
+
+char *engineNames[2] = {"recursive", "table"};
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Parses the tokens of ctx again with the engine asked for
+void reparse(KplContext *ctx, int table) {
+  if (!ctx->syntaxOnly)
+    cleanSymTab(ctx);
+  freeAst(ctx->ast);
+  ctx->tokenIndex = 0;
+  ctx->tableParser = table;
+  parseInput(ctx);
+}
+
+int samePrograms(KplContext *a, KplContext *b) {
+  int i;
+
+  if ((a->parseIncomplete != b->parseIncomplete) || (a->diagnosticCount != b->diagnosticCount))
+    return 0;
+  for (i = 0; i < a->diagnosticCount; i++)
+    if ((a->diagnostics[i].errorCode != b->diagnostics[i].errorCode) ||
+	(a->diagnostics[i].missing != b->diagnostics[i].missing) ||
+	(a->diagnostics[i].offset != b->diagnostics[i].offset))
+      return 0;
+  if (a->syntaxOnly)
+    return 1;
+
+  if ((a->ast->count != b->ast->count) || (a->ast->extraCount != b->ast->extraCount) ||
+      (memcmp(a->ast->nodes, b->ast->nodes, a->ast->count * sizeof(Node)) != 0) ||
+      (memcmp(a->ast->extra, b->ast->extra, a->ast->extraCount * sizeof(int)) != 0) ||
+      (a->symtab->objectCount != b->symtab->objectCount))
+    return 0;
+  for (i = 0; i < a->symtab->objectCount; i++)
+    if ((OBJECT(a->symtab, i)->kind != OBJECT(b->symtab, i)->kind) ||
+	(strcmp(OBJECT(a->symtab, i)->name, OBJECT(b->symtab, i)->name) != 0))
+      return 0;
+  return 1;
+}
+
+KplContext *openWith(char *fileName, int syntaxOnly, int table) {
+  KplContext *ctx = createContext();
+
+  ctx->preTokenize = 1;
+  ctx->syntaxOnly = syntaxOnly;
+  ctx->tableParser = table;
+  if (openProgram(ctx, fileName) == IO_ERROR) {
+    freeContext(ctx);
+    return NULL;
+  }
+  return ctx;
+}
+
+void benchFile(char *fileName, int repeat) {
+  KplContext *ctx[2];
+  double size, start, elapsed, first = 0;
+  int syntaxOnly, table, r;
+
+  for (syntaxOnly = 0; syntaxOnly <= 1; syntaxOnly++) {
+    ctx[0] = openWith(fileName, syntaxOnly, 0);
+    ctx[1] = openWith(fileName, syntaxOnly, 1);
+    if ((ctx[0] == NULL) || (ctx[1] == NULL)) {
+      printf("%s: can't read\n", fileName);
+      return;
+    }
+    size = ctx[0]->inputEnd - ctx[0]->inputBuffer;
+    if (!syntaxOnly)
+      printf("%s: %.0f bytes, %d tokens, %d errors\n", fileName, size, ctx[0]->tokens->count, ctx[0]->diagnosticCount);
+    if (!samePrograms(ctx[0], ctx[1]))
+      printf("%s: MISMATCH between the parsers\n", syntaxOnly ? "syntax-only" : "full");
+
+    for (table = 0; table <= 1; table++) {
+      start = now();
+      for (r = 0; r < repeat; r++)
+	reparse(ctx[table], table);
+      elapsed = now() - start;
+      if (table == 0)
+	first = elapsed;
+      printf("%11s %9s %8.2f ms %7.1f MB/s %6.2fx\n", syntaxOnly ? "syntax-only" : "full", engineNames[table],
+	     elapsed / repeat * 1e3, size * repeat / elapsed / 1e6, first / elapsed);
+    }
+
+    for (table = 0; table <= 1; table++) {
+      closeProgram(ctx[table]);
+      freeContext(ctx[table]);
+    }
+  }
+}
+
+// IF X = 0 THEN BEGIN, depth times, around one assignment
+int writeNested(char *fileName, int depth) {
+  FILE *f = fopen(fileName, "w");
+  int i;
+
+  if (f == NULL)
+    return 0;
+  fprintf(f, "PROGRAM DEEP;\nVAR X : INTEGER;\nBEGIN\n");
+  for (i = 0; i < depth; i++)
+    fprintf(f, "IF X = 0 THEN BEGIN\n");
+  fprintf(f, "X := 1\n");
+  for (i = 0; i < depth; i++)
+    fprintf(f, "END\n");
+  fprintf(f, "END.\n");
+  return fclose(f) == 0;
+}
+
+void benchNested(int depth) {
+  char fileName[] = "/tmp/bench_tableXXXXXX";
+  int fd = mkstemp(fileName);
+  int table, status;
+  pid_t child;
+
+  if ((fd < 0) || !writeNested(fileName, depth)) {
+    printf("can't write the nested program\n");
+    return;
+  }
+  close(fd);
+
+  printf("%d nested statements\n", depth);
+  for (table = 0; table <= 1; table++) {
+    fflush(stdout);
+    child = fork();
+    if (child == 0) {
+      double start = now();
+      KplContext *ctx = openWith(fileName, 0, table);
+
+      printf("%11s %9s %8.2f ms, %d errors\n", "nested", engineNames[table], (now() - start) * 1e3, ctx->diagnosticCount);
+      fflush(stdout);
+      _exit(0);
+    }
+    if ((child < 0) || (waitpid(child, &status, 0) < 0))
+      printf("%11s %9s can't run\n", "nested", engineNames[table]);
+    else if (WIFSIGNALED(status))
+      printf("%11s %9s killed by signal %d\n", "nested", engineNames[table], WTERMSIG(status));
+  }
+  unlink(fileName);
+}
+
+int main(int argc, char *argv[]) {
+  int repeat = DEFAULT_REPEAT;
+  int depth = 0;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+      repeat = atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-d") == 0) && (i + 1 < argc))
+      depth = atoi(argv[++i]);
+    else break;
+  }
+  if ((i >= argc) && (depth <= 0)) {
+    printf("usage: bench_table [-n repeat] [-d depth] file...\n");
+    return -1;
+  }
+
+  for (; i < argc; i++)
+    benchFile(argv[i], repeat);
+  if (depth > 0)
+    benchNested(depth);
+  return 0;
+}
@@ -0,0 +1,86 @@
+/* Grammar set check
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Compares the FIRST and FOLLOW sets that gramgen computes from
+// kpl.grammar with the token lists the parser checked its lookahead
+// against before they were generated. Run by make check-grammar, so that
+// a change to the grammar which moves one of these sets does not go
+// unnoticed. Prints the tokens that differ and exits with 1 if any do.
+
+#include <stdio.h>
+
+#include "token.h"
+#include "gramsets.h"
+
+#define END_OF_LIST -1
+
+// The cases of compileStatement()
+int firstStatement[] = {
+  TK_IDENT, KW_CALL, KW_BEGIN, KW_IF, KW_WHILE, KW_FOR, END_OF_LIST
+};
+
+// Where compileStatement() took the empty statement
+int followStatement[] = {
+  SB_SEMICOLON, KW_END, KW_ELSE, END_OF_LIST
+};
+
+// What compileArguments() accepted after a call without arguments
+int followArguments[] = {
+  SB_TIMES, SB_SLASH, SB_PLUS, SB_MINUS, KW_TO, KW_DO, SB_RPAR, SB_COMMA,
+  SB_EQ, SB_NEQ, SB_LE, SB_LT, SB_GE, SB_GT, SB_RSEL, SB_SEMICOLON,
+  KW_END, KW_ELSE, KW_THEN, END_OF_LIST
+};
+
+// What compileExpression() accepted at the end of an expression
+int followExpression[] = {
+  KW_TO, KW_DO, SB_RPAR, SB_COMMA, SB_EQ, SB_NEQ, SB_LE, SB_LT, SB_GE,
+  SB_GT, SB_RSEL, SB_SEMICOLON, KW_END, KW_ELSE, KW_THEN, END_OF_LIST
+};
+
+// The same, with the additive operators that may follow a term
+int followTerm[] = {
+  SB_PLUS, SB_MINUS, KW_TO, KW_DO, SB_RPAR, SB_COMMA, SB_EQ, SB_NEQ,
+  SB_LE, SB_LT, SB_GE, SB_GT, SB_RSEL, SB_SEMICOLON, KW_END, KW_ELSE,
+  KW_THEN, END_OF_LIST
+};
+
+TokenSet makeSet(int *list) {
+  TokenSet set = 0;
+
+  for (; *list != END_OF_LIST; list++)
+    set |= TOKEN_BIT(*list);
+  return set;
+}
+
+// Returns 1 when the generated set is the hand-written one
+int check(char *name, TokenSet generated, int *list) {
+  TokenSet expected = makeSet(list);
+  int tokenType;
+
+  if (generated == expected)
+    return 1;
+  for (tokenType = TK_NONE; tokenType <= SB_RSEL; tokenType++) {
+    if (IN_SET(generated, tokenType) && !IN_SET(expected, tokenType))
+      printf("%s: %s is in the grammar only\n", name, tokenToString(tokenType));
+    else if (!IN_SET(generated, tokenType) && IN_SET(expected, tokenType))
+      printf("%s: %s is in the parser only\n", name, tokenToString(tokenType));
+  }
+  return 0;
+}
+
+int main(void) {
+  int ok = 1;
+
+  ok = check("FIRST_STATEMENT", FIRST_STATEMENT, firstStatement) && ok;
+  ok = check("FOLLOW_STATEMENT", FOLLOW_STATEMENT, followStatement) && ok;
+  ok = check("FOLLOW_ARGUMENTS", FOLLOW_ARGUMENTS, followArguments) && ok;
+  ok = check("FOLLOW_FACTOR", FOLLOW_FACTOR, followArguments) && ok;
+  ok = check("FOLLOW_EXPRESSION", FOLLOW_EXPRESSION, followExpression) && ok;
+  ok = check("FOLLOW_TERM", FOLLOW_TERM, followTerm) && ok;
+
+  printf(ok ? "grammar sets OK\n" : "grammar sets differ from the parser\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include "context.h"
+#include "interner.h"
+#include "error.h"
+
+KplContext* createContext(void) {
+  KplContext *ctx = (KplContext*) calloc(1, sizeof(KplContext));
+  ctx->interner = createInterner();
+  ctx->maxErrors = DEFAULT_MAX_ERRORS;
+  return ctx;
+}
+
+void freeContext(KplContext *ctx) {
+  freeInterner(ctx->interner);
+  free(ctx->diagnostics);
+  free(ctx);
+}
@@ -0,0 +1,103 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __CONTEXT_H__
+#define __CONTEXT_H__
+
+#include <setjmp.h>
+#include "token.h"
+
+struct TokenBuffer_;
+struct Ast_;
+struct Interner_;
+struct SymTab_;
+struct Type_;
+struct Scope_;
+struct Object_;
+struct Diagnostic_;
+struct BodyQueue_;
+
+// All the state of one compilation. Nothing in the reader, scanner,
+// parser, symbol table or semantic checks lives outside of it, so that
+// several programs can be compiled at the same time, one context each.
+struct KplContext_ {
+  // Reader: the resident source and its line index
+  char *inputBuffer;
+  char *inputPtr;
+  char *inputEnd;
+  int inputMapped;
+  int *lineStarts;
+  int lineCount;
+  int currentChar;
+
+  // Scanner: engine selection and the identifier interner. Without an
+  // interner, identifiers are scanned with no symbol ID.
+  int dfaScanner;
+  struct Interner_ *interner;
+
+  // Parser: with preTokenize set, the tokens come from a buffer filled
+  // before parsing starts, by scanThreads threads or from the token cache
+  // file when tokenCache is set; tokenIndex is the entry after the
+  // lookahead. The statement parts are built into ast; with printAst
+  // set, they are printed after the symbol table. With syntaxOnly set,
+  // only the grammar is checked: there is no symbol table and no tree.
+  // With parseThreads above 1, the bodies of the subprograms of the
+  // program are skipped over into bodyQueue and parsed on that many
+  // threads once all their declarations are known. With lazyBodies set,
+  // the declarations of all subprograms are compiled but their statement
+  // parts are only kept as token ranges until something asks for them,
+  // see subprogramBody(). With tableParser set, pretokenized input is
+  // parsed by the LL(1) table of tableparser.c instead, all of it at once.
+  // parseIncomplete is set when the last parse gave up before the end of
+  // the program.
+  int preTokenize;
+  int scanThreads;
+  int parseThreads;
+  struct BodyQueue_ *bodyQueue;
+  int lazyBodies;
+  int tableParser;
+  int tokenCache;
+  struct TokenBuffer_ *tokens;
+  int tokenIndex;
+  Token currentToken;
+  Token lookAhead;
+  struct Ast_ *ast;
+  int printAst;
+  int syntaxOnly;
+  int parseIncomplete;
+
+  // Symbol table
+  struct SymTab_ *symtab;
+  struct Type_ *intType;
+  struct Type_ *charType;
+
+  // Semantics: where the pending lookup resumes, and the last object it
+  // may see there
+  struct Scope_ *lookupScope;
+  struct Object_ *lookupLimit;
+  int lookupGlobals;
+
+  // Errors unwind to here. With recordErrors set they are not printed
+  // but kept in errorCode and errorOffset. Otherwise they are collected in
+  // diagnostics and the parser resumes at recoveryJump, its innermost
+  // recovery point, until maxErrors of them have been reported.
+  jmp_buf errorJump;
+  int recordErrors;
+  int errorCode;
+  int errorOffset;
+  jmp_buf *recoveryJump;
+  struct Diagnostic_ *diagnostics;
+  int diagnosticCount;
+  int diagnosticCapacity;
+  int maxErrors;
+};
+
+typedef struct KplContext_ KplContext;
+
+KplContext* createContext(void);
+void freeContext(KplContext *ctx);
+
+#endif
@@ -99,3 +99,118 @@ void printScope(Scope* scope, int indent) {
   printObjectList(scope->objList, indent);
 }
 
+
+/******************************************************************/
+
+void printNodeList(Ast *ast, SymTab *symtab, int list, int indent) {
+  for (; list != NO_LIST; list = LIST_NEXT(ast, list))
+    printNode(ast, symtab, LIST_NODE(ast, list), indent);
+}
+
+// An absent statement is printed as Empty
+void printNode(Ast *ast, SymTab *symtab, NodeId id, int indent) {
+  Node *node;
+
+  pad(indent);
+  if (id == NO_NODE) {
+    printf("Empty\n");
+    return;
+  }
+
+  node = NODE(ast, id);
+  switch (node->kind) {
+  case N_ASSIGN:
+    printf("Assign\n");
+    printNode(ast, symtab, node->first, indent + 4);
+    printNode(ast, symtab, node->second, indent + 4);
+    break;
+  case N_CALL:
+    printf("Call %s\n", OBJECT(symtab, node->first)->name);
+    printNodeList(ast, symtab, node->second, indent + 4);
+    break;
+  case N_GROUP:
+    printf("Group\n");
+    printNodeList(ast, symtab, node->first, indent + 4);
+    break;
+  case N_IF:
+    printf("If\n");
+    printNode(ast, symtab, node->first, indent + 4);
+    printNode(ast, symtab, ast->extra[node->second], indent + 4);
+    printNode(ast, symtab, ast->extra[node->second + 1], indent + 4);
+    break;
+  case N_WHILE:
+    printf("While\n");
+    printNode(ast, symtab, node->first, indent + 4);
+    printNode(ast, symtab, node->second, indent + 4);
+    break;
+  case N_FOR:
+    printf("For %s\n", OBJECT(symtab, node->first)->name);
+    printNode(ast, symtab, ast->extra[node->second], indent + 4);
+    printNode(ast, symtab, ast->extra[node->second + 1], indent + 4);
+    printNode(ast, symtab, ast->extra[node->second + 2], indent + 4);
+    break;
+  case N_NUMBER:
+    printf("Number %d\n", node->first);
+    break;
+  case N_CHAR:
+    printf("Char \'%c\'\n", node->first);
+    break;
+  case N_CONSTANT:
+    printf("Const %s\n", OBJECT(symtab, node->first)->name);
+    break;
+  case N_VARIABLE:
+    printf("Var %s\n", OBJECT(symtab, node->first)->name);
+    break;
+  case N_PARAMETER:
+    printf("Param %s\n", OBJECT(symtab, node->first)->name);
+    break;
+  case N_FUNCTION:
+    printf("Function %s\n", OBJECT(symtab, node->first)->name);
+    printNodeList(ast, symtab, node->second, indent + 4);
+    break;
+  case N_INDEX:
+    printf("Index\n");
+    printNode(ast, symtab, node->first, indent + 4);
+    printNode(ast, symtab, node->second, indent + 4);
+    break;
+  case N_NEGATE:
+    printf("Negate\n");
+    printNode(ast, symtab, node->first, indent + 4);
+    break;
+  case N_BINARY:
+  case N_CONDITION:
+    printf("%s %s\n", (node->kind == N_BINARY) ? "Binary" : "Condition", tokenToString(node->op));
+    printNode(ast, symtab, node->first, indent + 4);
+    printNode(ast, symtab, node->second, indent + 4);
+    break;
+  }
+}
+
+// The body of obj, then those of the subprograms declared in it
+void printBodies(Ast *ast, SymTab *symtab, Object *obj, int indent) {
+  ObjectNode *list;
+  NodeId body;
+
+  switch (obj->kind) {
+  case OBJ_FUNCTION:
+    body = obj->funcAttrs->body;
+    list = obj->funcAttrs->scope->objList;
+    break;
+  case OBJ_PROCEDURE:
+    body = obj->procAttrs->body;
+    list = obj->procAttrs->scope->objList;
+    break;
+  case OBJ_PROGRAM:
+    body = obj->progAttrs->body;
+    list = obj->progAttrs->scope->objList;
+    break;
+  default:
+    return;
+  }
+
+  pad(indent);
+  printf("Body of %s\n", obj->name);
+  printNode(ast, symtab, body, indent + 4);
+  for (; list != NULL; list = list->next)
+    printBodies(ast, symtab, list->object, indent + 4);
+}
@@ -14,5 +14,7 @@ void printConstantValue(ConstantValue* value);
 void printObject(Object* obj, int indent);
 void printObjectList(ObjectNode* objList, int indent);
 void printScope(Scope* scope, int indent);
+void printNode(Ast *ast, SymTab *symtab, NodeId node, int indent);
+void printBodies(Ast *ast, SymTab *symtab, Object *obj, int indent);
 
 #endif
@@ -0,0 +1,192 @@
+/* Table-driven scanner
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// An alternative to getToken(): a DFA over the character classes of
+// charCodes[]. Every step is one table lookup; blanks and comments lead
+// back to the start state instead of recursing, and their bodies are
+// skipped in bulk by fastskip.c. The tokens, values and
+// diagnostics are exactly those of getToken().
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reader.h"
+#include "charcode.h"
+#include "token.h"
+#include "error.h"
+#include "scanner.h"
+#include "fastskip.h"
+#include "interner.h"
+
+extern CharCode charCodes[];
+
+// Pseudo character class for the end of the input
+#define CHAR_EOF (CHAR_UNKNOWN + 1)
+#define CLASS_COUNT (CHAR_EOF + 1)
+
+typedef enum {
+  S_START,
+  S_IDENT,
+  S_NUMBER,
+  S_LT,
+  S_GT,
+  S_EXCLAIMATION,
+  S_PERIOD,
+  S_COLON,
+  S_LPAR,
+  S_COMMENT,
+  S_COMMENT_TIMES,
+  S_QUOTE,
+  S_QUOTE_CHAR,
+  S_INVALID,
+  // The token ends with the last character read
+  S_PLUS, S_MINUS, S_TIMES, S_SLASH, S_EQ, S_COMMA, S_SEMICOLON, S_RPAR,
+  S_LE, S_GE, S_NEQ, S_RSEL, S_ASSIGN, S_LSEL, S_CHAR,
+  STATE_COUNT
+} DfaState;
+
+// A transition is either a state to move to after consuming the character
+// (>= 0), or an action taken without consuming it: emit a token, or
+// report an error at the start of the token or at the current character.
+#define EMIT(tokenType) (-1 - (tokenType))
+#define ERROR_AT_START(err) (-1000 - (err))
+#define ERROR_HERE(err) (-2000 - (err))
+
+#define ALL [0 ... CLASS_COUNT - 1]
+#define DONE(tokenType) { ALL = EMIT(tokenType) }
+
+static const short transitions[STATE_COUNT][CLASS_COUNT] = {
+  [S_START] = {
+    [CHAR_SPACE] = S_START,
+    [CHAR_LETTER] = S_IDENT,
+    [CHAR_DIGIT] = S_NUMBER,
+    [CHAR_PLUS] = S_PLUS,
+    [CHAR_MINUS] = S_MINUS,
+    [CHAR_TIMES] = S_TIMES,
+    [CHAR_SLASH] = S_SLASH,
+    [CHAR_LT] = S_LT,
+    [CHAR_GT] = S_GT,
+    [CHAR_EXCLAIMATION] = S_EXCLAIMATION,
+    [CHAR_EQ] = S_EQ,
+    [CHAR_COMMA] = S_COMMA,
+    [CHAR_PERIOD] = S_PERIOD,
+    [CHAR_COLON] = S_COLON,
+    [CHAR_SEMICOLON] = S_SEMICOLON,
+    [CHAR_SINGLEQUOTE] = S_QUOTE,
+    [CHAR_LPAR] = S_LPAR,
+    [CHAR_RPAR] = S_RPAR,
+    [CHAR_UNKNOWN] = S_INVALID,
+    [CHAR_EOF] = EMIT(TK_EOF)
+  },
+  [S_IDENT] = { ALL = EMIT(TK_IDENT), [CHAR_LETTER] = S_IDENT, [CHAR_DIGIT] = S_IDENT },
+  [S_NUMBER] = { ALL = EMIT(TK_NUMBER), [CHAR_DIGIT] = S_NUMBER },
+  [S_LT] = { ALL = EMIT(SB_LT), [CHAR_EQ] = S_LE },
+  [S_GT] = { ALL = EMIT(SB_GT), [CHAR_EQ] = S_GE },
+  [S_EXCLAIMATION] = { ALL = ERROR_AT_START(ERR_INVALID_SYMBOL), [CHAR_EQ] = S_NEQ },
+  [S_PERIOD] = { ALL = EMIT(SB_PERIOD), [CHAR_RPAR] = S_RSEL },
+  [S_COLON] = { ALL = EMIT(SB_COLON), [CHAR_EQ] = S_ASSIGN },
+  [S_LPAR] = { ALL = EMIT(SB_LPAR), [CHAR_PERIOD] = S_LSEL, [CHAR_TIMES] = S_COMMENT },
+  [S_COMMENT] = {
+    ALL = S_COMMENT,
+    [CHAR_TIMES] = S_COMMENT_TIMES,
+    [CHAR_EOF] = ERROR_HERE(ERR_END_OF_COMMENT)
+  },
+  [S_COMMENT_TIMES] = {
+    ALL = S_COMMENT,
+    [CHAR_TIMES] = S_COMMENT_TIMES,
+    [CHAR_RPAR] = S_START,
+    [CHAR_EOF] = ERROR_HERE(ERR_END_OF_COMMENT)
+  },
+  [S_QUOTE] = { ALL = S_QUOTE_CHAR, [CHAR_EOF] = ERROR_AT_START(ERR_INVALID_CONSTANT_CHAR) },
+  [S_QUOTE_CHAR] = { ALL = ERROR_AT_START(ERR_INVALID_CONSTANT_CHAR), [CHAR_SINGLEQUOTE] = S_CHAR },
+  [S_INVALID] = { ALL = ERROR_AT_START(ERR_INVALID_SYMBOL) },
+  [S_PLUS] = DONE(SB_PLUS),
+  [S_MINUS] = DONE(SB_MINUS),
+  [S_TIMES] = DONE(SB_TIMES),
+  [S_SLASH] = DONE(SB_SLASH),
+  [S_EQ] = DONE(SB_EQ),
+  [S_COMMA] = DONE(SB_COMMA),
+  [S_SEMICOLON] = DONE(SB_SEMICOLON),
+  [S_RPAR] = DONE(SB_RPAR),
+  [S_LE] = DONE(SB_LE),
+  [S_GE] = DONE(SB_GE),
+  [S_NEQ] = DONE(SB_NEQ),
+  [S_RSEL] = DONE(SB_RSEL),
+  [S_ASSIGN] = DONE(SB_ASSIGN),
+  [S_LSEL] = DONE(SB_LSEL),
+  [S_CHAR] = DONE(TK_CHAR)
+};
+
+Token getTokenDfa(KplContext *ctx) {
+  unsigned char *buffer = (unsigned char*) ctx->inputBuffer;
+  int size = ctx->inputEnd - ctx->inputBuffer;
+  int pos = (ctx->currentChar == EOF) ? size : ctx->inputPtr - ctx->inputBuffer - 1;
+  int start = pos;
+  int state = S_START;
+  int action;
+  Token token;
+
+  for (;;) {
+    // Runs of blanks and comment bodies are skipped in bulk
+    if (state == S_START) {
+      if ((pos < size) && (charCodes[buffer[pos]] == CHAR_SPACE))
+	pos = skipSpaces(ctx->inputBuffer + pos, ctx->inputEnd) - ctx->inputBuffer;
+    } else if (state == S_COMMENT) {
+      char *end = findCommentEnd(ctx->inputBuffer + pos, ctx->inputEnd);
+      if (end != NULL) {
+	state = S_START;
+	pos = end - ctx->inputBuffer;
+	continue;
+      }
+      pos = size;
+    }
+    action = transitions[state][(pos < size) ? charCodes[buffer[pos]] : CHAR_EOF];
+    if (state == S_START)
+      start = pos;
+    if (action < 0) break;
+    state = action;
+    pos ++;
+  }
+
+  // Leave the reader on the first character after the token
+  ctx->inputPtr = ctx->inputBuffer + pos;
+  readChar(ctx);
+
+  if (action <= ERROR_HERE(0)) {
+    error(ctx, ERROR_HERE(0) - action, pos);
+    return makeToken(TK_NONE, pos, 0);
+  }
+  if (action <= ERROR_AT_START(0)) {
+    error(ctx, ERROR_AT_START(0) - action, start);
+    return makeToken(TK_NONE, start, 0);
+  }
+
+  token = makeToken(EMIT(0) - action, start, 0);
+
+  switch (token.tokenType) {
+  case TK_IDENT:
+    token.tokenType = checkKeyword(ctx->inputBuffer + start, pos - start);
+    if (token.tokenType == TK_NONE) {
+      token.tokenType = TK_IDENT;
+      if (ctx->interner != NULL)
+	token.value = internName(ctx->interner, ctx->inputBuffer + start, pos - start);
+    }
+    break;
+  case TK_NUMBER:
+    token.value = digitsValue((char*) buffer + start, pos - start);
+    if (token.value < 0) {
+      error(ctx, ERR_NUMBER_TOO_LARGE, start);
+      return makeToken(TK_NONE, start, 0);
+    }
+    break;
+  case TK_CHAR:
+    token.value = buffer[start + 1];
+    break;
+  default:
+    break;
+  }
+  return token;
+}
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "reader.h"
 #include "error.h"
 
 #define NUM_OF_ERRORS 29
@@ -17,7 +18,7 @@ struct ErrorMessage {
 
 struct ErrorMessage errors[29] = {
   {ERR_END_OF_COMMENT, "End of comment expected."},
-  {ERR_IDENT_TOO_LONG, "Identifier too long."},
+  {ERR_NUMBER_TOO_LARGE, "Number too large."},
   {ERR_INVALID_CONSTANT_CHAR, "Invalid char constant."},
   {ERR_INVALID_SYMBOL, "Invalid symbol."},
   {ERR_INVALID_IDENT, "An identifier expected."},
@@ -47,18 +48,85 @@ struct ErrorMessage errors[29] = {
   {ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY, "The number of arguments and the number of parameters are inconsistent."}
 };
 
-void error(ErrorCode err, int lineNo, int colNo) {
-  int i;
-  for (i = 0 ; i < NUM_OF_ERRORS; i ++) 
-    if (errors[i].errorCode == err) {
-      printf("%d-%d:%s\n", lineNo, colNo, errors[i].message);
-      exit(0);
-    }
+// Adds a diagnostic unless it is where the previous one was: then it is a
+// consequence of that one and is dropped. Gives up on the program through
+// ctx->errorJump once maxErrors have been reported.
+void addDiagnostic(KplContext *ctx, ErrorCode err, TokenType missing, int offset) {
+  Diagnostic *diagnostic;
+
+  if ((ctx->diagnosticCount > 0) && (ctx->diagnostics[ctx->diagnosticCount - 1].offset == offset))
+    return;
+  if (ctx->diagnosticCount == ctx->diagnosticCapacity) {
+    ctx->diagnosticCapacity = (ctx->diagnosticCapacity == 0) ? 16 : 2 * ctx->diagnosticCapacity;
+    ctx->diagnostics = (Diagnostic*) realloc(ctx->diagnostics, ctx->diagnosticCapacity * sizeof(Diagnostic));
+  }
+  diagnostic = &ctx->diagnostics[ctx->diagnosticCount++];
+  diagnostic->errorCode = err;
+  diagnostic->missing = missing;
+  diagnostic->offset = offset;
+  if (ctx->diagnosticCount >= ctx->maxErrors)
+    longjmp(ctx->errorJump, 1);
+}
+
+// Unwinds to the innermost recovery point of the parser, or gives up on
+// the program when there is none and after a lexical error
+void report(KplContext *ctx, ErrorCode err, TokenType missing, int offset) {
+  addDiagnostic(ctx, err, missing, offset);
+  if ((ctx->recoveryJump == NULL) || ((missing == TK_NONE) && (err <= LAST_LEXICAL_ERROR)))
+    longjmp(ctx->errorJump, 1);
+  longjmp(*ctx->recoveryJump, 1);
+}
+
+// With ctx->recordErrors set, the error is kept in errorCode and
+// errorOffset for the scanner that asked for it
+void error(KplContext *ctx, ErrorCode err, int offset) {
+  if (ctx->recordErrors) {
+    ctx->errorCode = err;
+    ctx->errorOffset = offset;
+    longjmp(ctx->errorJump, 1);
+  }
+  report(ctx, err, TK_NONE, offset);
+}
+
+void missingToken(KplContext *ctx, TokenType tokenType, int offset) {
+  report(ctx, ERR_INVALID_SYMBOL, tokenType, offset);
 }
 
-void missingToken(TokenType tokenType, int lineNo, int colNo) {
-  printf("%d-%d:Missing %s\n", lineNo, colNo, tokenToString(tokenType));
-  exit(0);
+// Reports a missing token and returns, for a parser that can go on as if
+// it were there
+void insertedToken(KplContext *ctx, TokenType tokenType, int offset) {
+  addDiagnostic(ctx, ERR_INVALID_SYMBOL, tokenType, offset);
+}
+
+// Puts the diagnostics in source order, equal offsets in report order
+void sortDiagnostics(KplContext *ctx) {
+  Diagnostic diagnostic;
+  int i, j;
+
+  for (i = 1; i < ctx->diagnosticCount; i++) {
+    diagnostic = ctx->diagnostics[i];
+    for (j = i; (j > 0) && (ctx->diagnostics[j - 1].offset > diagnostic.offset); j--)
+      ctx->diagnostics[j] = ctx->diagnostics[j - 1];
+    ctx->diagnostics[j] = diagnostic;
+  }
+}
+
+// Prints the diagnostics in the order they were reported
+void printDiagnostics(KplContext *ctx) {
+  Diagnostic *diagnostic;
+  int i, j, lineNo, colNo;
+
+  for (i = 0; i < ctx->diagnosticCount; i++) {
+    diagnostic = &ctx->diagnostics[i];
+    getPosition(ctx, diagnostic->offset, &lineNo, &colNo);
+    if (diagnostic->missing != TK_NONE) {
+      printf("%d-%d:Missing %s\n", lineNo, colNo, tokenToString(diagnostic->missing));
+      continue;
+    }
+    for (j = 0 ; j < NUM_OF_ERRORS; j ++)
+      if (errors[j].errorCode == diagnostic->errorCode)
+	printf("%d-%d:%s\n", lineNo, colNo, errors[j].message);
+  }
 }
 
 void assert(char *msg) {
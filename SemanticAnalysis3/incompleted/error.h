@@ -6,11 +6,12 @@
 
 #ifndef __ERROR_H__
 #define __ERROR_H__
+#include "context.h"
 #include "token.h"
 
 typedef enum {
   ERR_END_OF_COMMENT,
-  ERR_IDENT_TOO_LONG,
+  ERR_NUMBER_TOO_LARGE,
   ERR_INVALID_CONSTANT_CHAR,
   ERR_INVALID_SYMBOL,
   ERR_INVALID_IDENT,
@@ -40,8 +41,27 @@ typedef enum {
   ERR_PARAMETERS_ARGUMENTS_INCONSISTENCY
 } ErrorCode;
 
-void error(ErrorCode err, int lineNo, int colNo);
-void missingToken(TokenType tokenType, int lineNo, int colNo);
+// The errors before this one are found by the scanner. The token stream
+// stops at them, so they end the compilation.
+#define LAST_LEXICAL_ERROR ERR_INVALID_SYMBOL
+
+#define DEFAULT_MAX_ERRORS 20
+
+// One reported error. A missing token has its type in missing, any other
+// error has TK_NONE there.
+struct Diagnostic_ {
+  ErrorCode errorCode;
+  TokenType missing;
+  int offset;
+};
+
+typedef struct Diagnostic_ Diagnostic;
+
+void error(KplContext *ctx, ErrorCode err, int offset);
+void missingToken(KplContext *ctx, TokenType tokenType, int offset);
+void insertedToken(KplContext *ctx, TokenType tokenType, int offset);
+void sortDiagnostics(KplContext *ctx);
+void printDiagnostics(KplContext *ctx);
 void assert(char *msg);
 
 #endif
@@ -0,0 +1,156 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Blank and comment skipping, the scanner's inner loops on indented or
+// heavily commented sources. On x86 they test 16 (SSE2) or 32 (AVX2)
+// characters at a time; the variant is chosen once from the CPU at start
+// up, and every other machine uses the scalar loops.
+
+#include <stddef.h>
+#include "charcode.h"
+#include "fastskip.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
+
+#define SCALAR_PROLOGUE 32
+
+extern CharCode charCodes[];
+
+char* skipSpacesScalar(char *p, char *end) {
+  while ((p < end) && (charCodes[(unsigned char) *p] == CHAR_SPACE))
+    p ++;
+  return p;
+}
+
+char* findCommentEndScalar(char *p, char *end) {
+  for (; p + 1 < end; p++)
+    if ((p[0] == '*') && (p[1] == ')'))
+      return p + 2;
+  return NULL;
+}
+
+#ifdef HAVE_X86_SIMD
+
+// CHAR_SPACE is ' ' and '\t' to '\r': a byte is blank when it equals ' '
+// or when c - '\t', taken unsigned, is at most 4.
+
+__attribute__((target("sse2")))
+char* skipSpacesSse2(char *p, char *end) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+
+  while (p + 16 <= end) {
+    __m128i v = _mm_loadu_si128((const __m128i*) p);
+    __m128i control = _mm_sub_epi8(v, tab);
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+				 _mm_cmpeq_epi8(_mm_min_epu8(control, four), control));
+    unsigned mask = _mm_movemask_epi8(blank);
+    if (mask != 0xFFFF)
+      return p + __builtin_ctz(~mask);
+    p += 16;
+  }
+  return skipSpacesScalar(p, end);
+}
+
+__attribute__((target("sse2")))
+char* findCommentEndSse2(char *p, char *end) {
+  const __m128i times = _mm_set1_epi8('*');
+  const __m128i rpar = _mm_set1_epi8(')');
+
+  while (p + 17 <= end) {
+    __m128i v = _mm_loadu_si128((const __m128i*) p);
+    __m128i next = _mm_loadu_si128((const __m128i*) (p + 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v, times),
+						    _mm_cmpeq_epi8(next, rpar)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask) + 2;
+    p += 16;
+  }
+  return findCommentEndScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+char* skipSpacesAvx2(char *p, char *end) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4);
+
+  while (p + 32 <= end) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) p);
+    __m256i control = _mm256_sub_epi8(v, tab);
+    __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+				    _mm256_cmpeq_epi8(_mm256_min_epu8(control, four), control));
+    unsigned mask = _mm256_movemask_epi8(blank);
+    if (mask != 0xFFFFFFFF)
+      return p + __builtin_ctz(~mask);
+    p += 32;
+  }
+  return skipSpacesSse2(p, end);
+}
+
+__attribute__((target("avx2")))
+char* findCommentEndAvx2(char *p, char *end) {
+  const __m256i times = _mm256_set1_epi8('*');
+  const __m256i rpar = _mm256_set1_epi8(')');
+
+  while (p + 33 <= end) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) p);
+    __m256i next = _mm256_loadu_si256((const __m256i*) (p + 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v, times),
+							  _mm256_cmpeq_epi8(next, rpar)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask) + 2;
+    p += 32;
+  }
+  return findCommentEndSse2(p, end);
+}
+
+#endif
+
+char* (*skipSpacesImpl)(char *p, char *end) = skipSpacesScalar;
+char* (*findCommentEndImpl)(char *p, char *end) = findCommentEndScalar;
+
+__attribute__((constructor))
+void selectSkipFunctions(void) {
+#ifdef HAVE_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    skipSpacesImpl = skipSpacesAvx2;
+    findCommentEndImpl = findCommentEndAvx2;
+  } else if (__builtin_cpu_supports("sse2")) {
+    skipSpacesImpl = skipSpacesSse2;
+    findCommentEndImpl = findCommentEndSse2;
+  }
+#endif
+}
+
+// Most blank runs are a single space and many comments are short: the
+// first characters are checked inline, and only longer runs pay for the
+// indirect call and the vector setup.
+char* skipSpaces(char *p, char *end) {
+  char *limit = (end - p > SCALAR_PROLOGUE) ? p + SCALAR_PROLOGUE : end;
+
+  while ((p < limit) && (charCodes[(unsigned char) *p] == CHAR_SPACE))
+    p ++;
+  if (p < limit || p == end)
+    return p;
+  return skipSpacesImpl(p, end);
+}
+
+char* findCommentEnd(char *p, char *end) {
+  char *limit = (end - p > SCALAR_PROLOGUE + 1) ? p + SCALAR_PROLOGUE : end - 1;
+
+  for (; p < limit; p++)
+    if ((p[0] == '*') && (p[1] == ')'))
+      return p + 2;
+  if (limit >= end - 1)
+    return NULL;
+  return findCommentEndImpl(p, end);
+}
@@ -0,0 +1,15 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __FASTSKIP_H__
+#define __FASTSKIP_H__
+
+// Returns the first character in [p, end) that is not a CHAR_SPACE, or end
+char* skipSpaces(char *p, char *end);
+// Returns the character after the first "*)" in [p, end), or NULL
+char* findCommentEnd(char *p, char *end);
+
+#endif
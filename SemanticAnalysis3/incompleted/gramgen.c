@@ -0,0 +1,685 @@
+/* FIRST/FOLLOW set and LL(1) table generator
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Reads a grammar in Wirth's EBNF, see kpl.grammar, computes the FIRST
+// and FOLLOW sets of every rule and prints them as token bitmasks:
+// FIRST_<RULE> and FOLLOW_<RULE>, with the rule name in upper case and
+// its words separated by underscores. The parser tests its lookahead
+// against them with a single AND.
+//
+// With -t, prints the LL(1) parse table of the grammar instead, for
+// tableparser.c. The options, repetitions and groups of alternatives in
+// the rules become nonterminals of their own, so that every production is
+// a plain sequence of terminals, nonterminals and semantic actions. An
+// option or a repetition is taken whenever the lookahead can start it,
+// which settles the dangling ELSE as the recursive descent parser does;
+// any other conflict is an error.
+//
+// usage: gramgen [-t] grammar > gramsets.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_SYMBOLS 128
+#define MAX_EXPRS 1024
+#define MAX_NAME_LEN 32
+#define MAX_TERMINALS 64
+#define MAX_ACTIONS 128
+#define MAX_NONTERMINALS 128
+#define MAX_PRODUCTIONS 255
+#define MAX_PRODUCTION_SYMBOLS 4096
+#define MAX_SEQUENCE 64
+
+#define NONE -1
+
+typedef unsigned long long Set;
+
+enum ExprKind {
+  E_SYMBOL,
+  E_ACTION,
+  E_SEQUENCE,
+  E_CHOICE,
+  E_OPTION,
+  E_REPEAT
+};
+
+// A node of a rule body. The parts of a sequence or the alternatives of
+// a choice are chained through next, starting at child. symbol is the
+// index of the symbol, or of the action. follow is what can come after
+// the node.
+struct Expr {
+  enum ExprKind kind;
+  int symbol;
+  int child, next;
+  Set follow;
+};
+
+// A symbol is a rule when it has a body, a terminal otherwise. A rule is
+// nonterminal number nonterminal of the table.
+struct Symbol {
+  char name[MAX_NAME_LEN + 1];
+  int body;
+  int bit;
+  int nullable;
+  Set first, follow;
+  int nonterminal;
+};
+
+struct Expr exprs[MAX_EXPRS];
+int exprCount = 0;
+struct Symbol symbols[MAX_SYMBOLS];
+int symbolCount = 0;
+char actions[MAX_ACTIONS][MAX_NAME_LEN + 1];
+int actionCount = 0;
+
+char *input;
+int lineNo = 1;
+char lexeme[MAX_NAME_LEN + 1];
+int lookAhead;
+
+#define NAME 256
+
+void fail(char *message) {
+  fprintf(stderr, "gramgen: line %d: %s\n", lineNo, message);
+  exit(1);
+}
+
+// Reads the next name or punctuation character into lookAhead
+void next(void) {
+  int length = 0;
+
+  for (;;) {
+    while (isspace((unsigned char) *input))
+      if (*input++ == '\n') lineNo ++;
+    if (*input != '#') break;
+    while ((*input != '\0') && (*input != '\n')) input ++;
+  }
+
+  if (isalpha((unsigned char) *input) || (*input == '_')) {
+    while (isalnum((unsigned char) *input) || (*input == '_')) {
+      if (length == MAX_NAME_LEN) fail("name too long");
+      lexeme[length++] = *input++;
+    }
+    lexeme[length] = '\0';
+    lookAhead = NAME;
+  } else if (*input == '\0') {
+    lookAhead = EOF;
+  } else lookAhead = *input++;
+}
+
+void expect(int c, char *message) {
+  if (lookAhead != c) fail(message);
+  next();
+}
+
+int lookupSymbol(char *name) {
+  int i;
+
+  for (i = 0; i < symbolCount; i++)
+    if (strcmp(symbols[i].name, name) == 0) return i;
+  if (symbolCount == MAX_SYMBOLS) fail("too many symbols");
+  strcpy(symbols[symbolCount].name, name);
+  symbols[symbolCount].body = NONE;
+  return symbolCount ++;
+}
+
+int lookupAction(char *name) {
+  int i;
+
+  for (i = 0; i < actionCount; i++)
+    if (strcmp(actions[i], name) == 0) return i;
+  if (actionCount == MAX_ACTIONS) fail("too many actions");
+  strcpy(actions[actionCount], name);
+  return actionCount ++;
+}
+
+int newExpr(enum ExprKind kind, int symbol, int child) {
+  if (exprCount == MAX_EXPRS) fail("grammar too large");
+  exprs[exprCount].kind = kind;
+  exprs[exprCount].symbol = symbol;
+  exprs[exprCount].child = child;
+  exprs[exprCount].next = NONE;
+  exprs[exprCount].follow = 0;
+  return exprCount ++;
+}
+
+/******************************************************************/
+
+int parseChoice(void);
+
+int parseFactor(void) {
+  int e;
+
+  switch (lookAhead) {
+  case NAME:
+    e = newExpr(E_SYMBOL, lookupSymbol(lexeme), NONE);
+    next();
+    return e;
+  case '@':
+    next();
+    if (lookAhead != NAME) fail("action name expected");
+    e = newExpr(E_ACTION, lookupAction(lexeme), NONE);
+    next();
+    return e;
+  case '[':
+    next();
+    e = newExpr(E_OPTION, NONE, parseChoice());
+    expect(']', "']' expected");
+    return e;
+  case '{':
+    next();
+    e = newExpr(E_REPEAT, NONE, parseChoice());
+    expect('}', "'}' expected");
+    return e;
+  case '(':
+    next();
+    e = parseChoice();
+    expect(')', "')' expected");
+    return e;
+  default:
+    fail("name, '@', '[', '{' or '(' expected");
+    return NONE;
+  }
+}
+
+int parseSequence(void) {
+  int e = newExpr(E_SEQUENCE, NONE, NONE);
+  int *last = &exprs[e].child;
+
+  while ((lookAhead == NAME) || (lookAhead == '@') || (lookAhead == '[') || (lookAhead == '{') || (lookAhead == '(')) {
+    *last = parseFactor();
+    last = &exprs[*last].next;
+  }
+  return e;
+}
+
+int parseChoice(void) {
+  int e = newExpr(E_CHOICE, NONE, parseSequence());
+  int last = exprs[e].child;
+
+  while (lookAhead == '|') {
+    next();
+    exprs[last].next = parseSequence();
+    last = exprs[last].next;
+  }
+  return e;
+}
+
+// Rule = Name '=' Choice '.'
+void parseGrammar(void) {
+  int rule;
+
+  next();
+  while (lookAhead != EOF) {
+    if (lookAhead != NAME) fail("rule name expected");
+    rule = lookupSymbol(lexeme);
+    if (symbols[rule].body != NONE) fail("rule defined twice");
+    next();
+    expect('=', "'=' expected");
+    symbols[rule].body = parseChoice();
+    expect('.', "'.' expected");
+  }
+  if (symbolCount == 0) fail("empty grammar");
+}
+
+/******************************************************************/
+
+Set firstOf(int e, int *nullable) {
+  Set set = 0;
+  int child, childNullable;
+
+  switch (exprs[e].kind) {
+  case E_SYMBOL:
+    *nullable = symbols[exprs[e].symbol].nullable;
+    return symbols[exprs[e].symbol].first;
+  case E_ACTION:
+    *nullable = 1;
+    return 0;
+  case E_SEQUENCE:
+    *nullable = 1;
+    for (child = exprs[e].child; (child != NONE) && *nullable; child = exprs[child].next)
+      set |= firstOf(child, nullable);
+    return set;
+  case E_CHOICE:
+    *nullable = 0;
+    for (child = exprs[e].child; child != NONE; child = exprs[child].next) {
+      set |= firstOf(child, &childNullable);
+      *nullable |= childNullable;
+    }
+    return set;
+  default:
+    *nullable = 1;
+    return firstOf(exprs[e].child, &childNullable);
+  }
+}
+
+int addFollow(int e, Set follow);
+
+// Gives every part of a sequence, from e on, what can come after it and
+// returns the FIRST set of the whole suffix followed by follow
+Set addFollowSequence(int e, Set follow, int *changed) {
+  Set after, first;
+  int nullable;
+
+  if (e == NONE) return follow;
+  after = addFollowSequence(exprs[e].next, follow, changed);
+  *changed |= addFollow(e, after);
+  first = firstOf(e, &nullable);
+  return nullable ? (first | after) : first;
+}
+
+// Returns whether a FOLLOW set grew. What can come after the node itself
+// is kept for the table.
+int addFollow(int e, Set follow) {
+  struct Symbol *symbol;
+  int child, changed = 0, nullable;
+
+  exprs[e].follow |= follow;
+  switch (exprs[e].kind) {
+  case E_ACTION:
+    return 0;
+  case E_SYMBOL:
+    symbol = &symbols[exprs[e].symbol];
+    if ((symbol->body == NONE) || ((symbol->follow | follow) == symbol->follow))
+      return 0;
+    symbol->follow |= follow;
+    return 1;
+  case E_SEQUENCE:
+    addFollowSequence(exprs[e].child, follow, &changed);
+    return changed;
+  case E_CHOICE:
+    for (child = exprs[e].child; child != NONE; child = exprs[child].next)
+      changed |= addFollow(child, follow);
+    return changed;
+  case E_OPTION:
+    return addFollow(exprs[e].child, follow);
+  default:
+    return addFollow(exprs[e].child, follow | firstOf(exprs[e].child, &nullable));
+  }
+}
+
+// end is the terminal that follows the start symbol
+void computeSets(int end) {
+  int i, nullable, changed, bitCount = 0;
+  Set first;
+
+  for (i = 0; i < symbolCount; i++)
+    if (symbols[i].body == NONE) {
+      if (bitCount == MAX_TERMINALS) fail("more than 64 terminals");
+      symbols[i].bit = bitCount ++;
+      symbols[i].first = ((Set) 1) << symbols[i].bit;
+    }
+
+  do {
+    changed = 0;
+    for (i = 0; i < symbolCount; i++)
+      if (symbols[i].body != NONE) {
+	first = firstOf(symbols[i].body, &nullable);
+	if ((first != symbols[i].first) || (nullable != symbols[i].nullable)) {
+	  symbols[i].first = first;
+	  symbols[i].nullable = nullable;
+	  changed = 1;
+	}
+      }
+  } while (changed);
+
+  symbols[0].follow = symbols[end].first;
+  do {
+    changed = 0;
+    for (i = 0; i < symbolCount; i++)
+      if (symbols[i].body != NONE)
+	changed |= addFollow(symbols[i].body, symbols[i].follow);
+  } while (changed);
+}
+
+/******************************************************************/
+
+// A symbol of a production
+enum ItemKind {
+  I_TERMINAL,
+  I_NONTERMINAL,
+  I_ACTION
+};
+
+struct Item {
+  enum ItemKind kind;
+  int index;
+};
+
+// The nonterminals of the table are the rules, then the options,
+// repetitions and groups of alternatives in their bodies. rule is the
+// rule the nonterminal is, or is a part of, and expr its body.
+struct Nonterminal {
+  int rule;
+  int expr;
+  int number;
+};
+
+// fallback is set for the empty production of an option or a repetition,
+// which is only taken on a lookahead that nothing else is taken on
+struct Production {
+  int lhs;
+  int start, length;
+  Set first;
+  int nullable;
+  int fallback;
+};
+
+struct Nonterminal nonterminals[MAX_NONTERMINALS];
+int nonterminalCount = 0;
+struct Production productions[MAX_PRODUCTIONS];
+int productionCount = 0;
+struct Item items[MAX_PRODUCTION_SYMBOLS];
+int itemCount = 0;
+// The production of a nonterminal for a terminal bit, plus one
+int table[MAX_NONTERMINALS][MAX_TERMINALS];
+
+void failRule(int rule, char *message, char *name) {
+  fprintf(stderr, "gramgen: %s: %s%s\n", symbols[rule].name, message, name);
+  exit(1);
+}
+
+// number tells nonterminals of the same rule apart
+int newNonterminal(int rule, int expr) {
+  int n = nonterminalCount, i;
+
+  if (nonterminalCount == MAX_NONTERMINALS) fail("too many nonterminals");
+  nonterminals[n].rule = rule;
+  nonterminals[n].expr = expr;
+  nonterminals[n].number = 0;
+  for (i = 0; i < n; i++)
+    if (nonterminals[i].rule == rule) nonterminals[n].number ++;
+  return nonterminalCount ++;
+}
+
+void addProduction(int lhs, struct Item *sequence, int length, Set first, int nullable, int fallback) {
+  struct Production *production;
+
+  if (productionCount == MAX_PRODUCTIONS) fail("too many productions");
+  if (itemCount + length > MAX_PRODUCTION_SYMBOLS) fail("productions too long");
+  production = &productions[productionCount ++];
+  production->lhs = lhs;
+  production->start = itemCount;
+  production->length = length;
+  production->first = first;
+  production->nullable = nullable;
+  production->fallback = fallback;
+  memcpy(items + itemCount, sequence, length * sizeof(struct Item));
+  itemCount += length;
+}
+
+int addItem(struct Item *sequence, int length, enum ItemKind kind, int index) {
+  if (length == MAX_SEQUENCE) fail("production too long");
+  sequence[length].kind = kind;
+  sequence[length].index = index;
+  return length + 1;
+}
+
+void addAlternatives(int lhs, int choice, int repeat);
+
+// Appends what stands for e, a part of a sequence, to sequence and
+// returns its new length
+int flattenPart(int lhs, int e, struct Item *sequence, int length) {
+  int rule = nonterminals[lhs].rule;
+  int n, part;
+
+  switch (exprs[e].kind) {
+  case E_SYMBOL:
+    if (symbols[exprs[e].symbol].body == NONE)
+      return addItem(sequence, length, I_TERMINAL, exprs[e].symbol);
+    return addItem(sequence, length, I_NONTERMINAL, symbols[exprs[e].symbol].nonterminal);
+  case E_ACTION:
+    return addItem(sequence, length, I_ACTION, exprs[e].symbol);
+  case E_CHOICE:
+    // A group of one alternative is spelled out in place
+    if (exprs[exprs[e].child].next == NONE) {
+      for (part = exprs[exprs[e].child].child; part != NONE; part = exprs[part].next)
+        length = flattenPart(lhs, part, sequence, length);
+      return length;
+    }
+    n = newNonterminal(rule, e);
+    addAlternatives(n, e, 0);
+    return addItem(sequence, length, I_NONTERMINAL, n);
+  default:
+    n = newNonterminal(rule, e);
+    addAlternatives(n, exprs[e].child, exprs[e].kind == E_REPEAT);
+    addProduction(n, NULL, 0, 0, 1, 1);
+    return addItem(sequence, length, I_NONTERMINAL, n);
+  }
+}
+
+// A production for each alternative of choice. Those of a repetition
+// end with the repetition again.
+void addAlternatives(int lhs, int choice, int repeat) {
+  struct Item sequence[MAX_SEQUENCE];
+  int alternative, part, length, nullable;
+  Set first;
+
+  for (alternative = exprs[choice].child; alternative != NONE; alternative = exprs[alternative].next) {
+    length = 0;
+    for (part = exprs[alternative].child; part != NONE; part = exprs[part].next)
+      length = flattenPart(lhs, part, sequence, length);
+    first = firstOf(alternative, &nullable);
+    if (repeat) {
+      if (nullable) failRule(nonterminals[lhs].rule, "repetition of what can be empty", "");
+      length = addItem(sequence, length, I_NONTERMINAL, lhs);
+    }
+    addProduction(lhs, sequence, length, first, nullable, 0);
+  }
+}
+
+char *terminalName(int bit) {
+  int i;
+
+  for (i = 0; i < symbolCount; i++)
+    if ((symbols[i].body == NONE) && (symbols[i].bit == bit)) return symbols[i].name;
+  return NULL;
+}
+
+// The empty productions go last, to the lookaheads left
+void fillTable(void) {
+  struct Production *production;
+  int p, t, fallback;
+  Set lookAheads;
+
+  for (fallback = 0; fallback <= 1; fallback++)
+    for (p = 0; p < productionCount; p++) {
+      production = &productions[p];
+      if (production->fallback != fallback)
+        continue;
+      lookAheads = production->first;
+      if (production->nullable)
+        lookAheads |= exprs[nonterminals[production->lhs].expr].follow;
+      for (t = 0; t < MAX_TERMINALS; t++) {
+        if ((lookAheads & (((Set) 1) << t)) == 0)
+          continue;
+        if (table[production->lhs][t] == 0)
+          table[production->lhs][t] = p + 1;
+        else if (!fallback)
+          failRule(nonterminals[production->lhs].rule, "LL(1) conflict on ", terminalName(t));
+      }
+    }
+}
+
+void buildTable(void) {
+  int i;
+
+  for (i = 0; i < symbolCount; i++)
+    if (symbols[i].body != NONE)
+      symbols[i].nonterminal = newNonterminal(i, symbols[i].body);
+  for (i = 0; i < symbolCount; i++)
+    if (symbols[i].body != NONE)
+      addAlternatives(symbols[i].nonterminal, symbols[i].body, 0);
+  // A grammar symbol of the table is one byte
+  if (MAX_TERMINALS + nonterminalCount + actionCount > 256) fail("grammar too large for the table");
+  fillTable();
+}
+
+/******************************************************************/
+
+// AssignSt becomes ASSIGN_ST
+void printUpperName(char *prefix, char *name) {
+  int i;
+
+  printf("%s_", prefix);
+  for (i = 0; name[i] != '\0'; i++) {
+    if ((i > 0) && isupper((unsigned char) name[i]) && islower((unsigned char) name[i - 1]))
+      printf("_");
+    printf("%c", toupper((unsigned char) name[i]));
+  }
+}
+
+void printMacroName(char *prefix, char *name) {
+  printf("#define ");
+  printUpperName(prefix, name);
+}
+
+void printSet(Set set) {
+  int i, count = 0;
+
+  if (set == 0) {
+    printf(" ((TokenSet) 0)\n");
+    return;
+  }
+  printf(" (");
+  for (i = 0; i < symbolCount; i++)
+    if ((symbols[i].body == NONE) && (set & symbols[i].first)) {
+      printf(count > 0 ? " | TOKEN_BIT(%s)" : "TOKEN_BIT(%s)", symbols[i].name);
+      count ++;
+    }
+  printf(")\n");
+}
+
+// Block, or Block#2 for the second nonterminal made out of its body
+void printNonterminal(int n) {
+  printf("%s", symbols[nonterminals[n].rule].name);
+  if (nonterminals[n].number > 0)
+    printf("#%d", nonterminals[n].number);
+}
+
+void printItem(struct Item *item) {
+  switch (item->kind) {
+  case I_TERMINAL:
+    printf("%s", symbols[item->index].name);
+    break;
+  case I_NONTERMINAL:
+    printf("FIRST_NONTERMINAL + %d", item->index);
+    break;
+  default:
+    printf("FIRST_ACTION + ");
+    printUpperName("ACTION", actions[item->index]);
+    break;
+  }
+}
+
+// The symbols of production p are productionSymbols[productionStart[p]]
+// up to productionStart[p + 1], and parseTable[n][t] is the production
+// of nonterminal n for lookahead t plus one, 0 when there is none
+void printTable(char *fileName) {
+  struct Production *production;
+  int i, j, t, count;
+
+  printf("/* Generated by gramgen -t from %s. Do not edit. */\n\n", fileName);
+  printf("#define NONTERMINAL_COUNT %d\n", nonterminalCount);
+  printf("#define PRODUCTION_COUNT %d\n", productionCount);
+  printf("#define FIRST_NONTERMINAL (SB_RSEL + 1)\n");
+  printf("#define FIRST_ACTION (FIRST_NONTERMINAL + NONTERMINAL_COUNT)\n\n");
+
+  printf("enum GrammarAction {\n");
+  for (i = 0; i < actionCount; i++) {
+    printf("  ");
+    printUpperName("ACTION", actions[i]);
+    printf(",\n");
+  }
+  printf("  ACTION_COUNT\n};\n\n");
+
+  printf("unsigned short productionStart[PRODUCTION_COUNT + 1] = {");
+  for (i = 0; i <= productionCount; i++)
+    printf(i % 16 ? " %d," : "\n  %d,", (i < productionCount) ? productions[i].start : itemCount);
+  printf("\n};\n\n");
+
+  printf("unsigned char productionSymbols[%d] = {\n", (itemCount > 0) ? itemCount : 1);
+  for (i = 0; i < productionCount; i++) {
+    production = &productions[i];
+    printf("  /* %d ", i);
+    printNonterminal(production->lhs);
+    printf(" */");
+    for (j = 0; j < production->length; j++) {
+      printf(" ");
+      printItem(&items[production->start + j]);
+      printf(",");
+    }
+    printf("\n");
+  }
+  printf("};\n\n");
+
+  printf("unsigned char parseTable[NONTERMINAL_COUNT][FIRST_NONTERMINAL] = {\n");
+  for (i = 0; i < nonterminalCount; i++) {
+    printf("  /* ");
+    printNonterminal(i);
+    printf(" */ {");
+    for (t = 0, count = 0; t < MAX_TERMINALS; t++)
+      if (table[i][t] != 0)
+        printf(count++ > 0 ? ", [%s] = %d" : "[%s] = %d", terminalName(t), table[i][t]);
+    printf("},\n");
+  }
+  printf("};\n");
+}
+
+char *readGrammar(char *fileName) {
+  FILE *f = fopen(fileName, "rb");
+  char *buffer;
+  long size;
+
+  if (f == NULL) return NULL;
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  rewind(f);
+  buffer = (char *) malloc(size + 1);
+  if ((buffer == NULL) || (fread(buffer, 1, size, f) != (size_t) size)) {
+    fclose(f);
+    return NULL;
+  }
+  buffer[size] = '\0';
+  fclose(f);
+  return buffer;
+}
+
+int main(int argc, char *argv[]) {
+  int parseTable = (argc == 3) && (strcmp(argv[1], "-t") == 0);
+  char *fileName = argv[argc - 1];
+  int i;
+
+  if ((argc != 2) && !parseTable) {
+    fprintf(stderr, "usage: gramgen [-t] grammar\n");
+    return 1;
+  }
+  if ((input = readGrammar(fileName)) == NULL) {
+    fprintf(stderr, "gramgen: can't read %s\n", fileName);
+    return 1;
+  }
+  parseGrammar();
+  // The first rule is the start symbol, followed by the end of the input
+  computeSets(lookupSymbol("TK_EOF"));
+
+  if (parseTable) {
+    buildTable();
+    printTable(fileName);
+    return 0;
+  }
+
+  printf("/* Generated by gramgen from %s. Do not edit. */\n\n", fileName);
+  for (i = 0; i < symbolCount; i++)
+    if (symbols[i].body != NONE) {
+      printMacroName("FIRST", symbols[i].name);
+      printSet(symbols[i].first);
+      printMacroName("FOLLOW", symbols[i].name);
+      printSet(symbols[i].follow);
+    }
+  return 0;
+}
@@ -0,0 +1,428 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Incremental parsing for editors. An edit is first applied to the token
+// stream by relexEdit(). When the tokens it replaced are all inside the
+// block of one subprogram, after its first token and before its END, and
+// the block still ends at that END, nothing outside of the block changes:
+// the parse up to it is the same, and so is the state it leaves behind,
+// as what a block declares is only seen from inside it. Then only that
+// block is parsed again, into the scope of its subprogram, and the rest of
+// the tree and of the symbol table is kept.
+//
+// Whether the block has to be parsed at all is decided by a fingerprint
+// of its tokens, their types and values. When the edit only touched blanks
+// or comments, or spelled a token another way, the old tree stands and
+// only the offsets in it move.
+//
+// The nodes of a tree are placed from the BEGIN of their statement part,
+// so the statement parts after the edit only move where they start. The
+// edit is in none of them but that of the edited block, and the work it
+// takes is in proportion to the block, not to the program.
+//
+// The old tree of a block parsed again is left in the arena and its
+// objects leave holes in the object table. Once there is more of them than
+// of the program, the program is parsed again from the start, as it is
+// after every edit that cannot be kept to one block.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+#include "tokenbuffer.h"
+#include "relex.h"
+#include "ast.h"
+#include "symtab.h"
+#include "error.h"
+#include "parser.h"
+#include "incremental.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// The attributes of a subprogram that reparsing works on
+typedef struct {
+  int *firstToken;
+  int *lastToken;
+  int *bodyToken;
+  int *pending;
+  NodeId *body;
+  int *bodyOffset;
+  Scope *scope;
+  ObjectNode *paramList;
+} Subprogram;
+
+// The edited block as it was before the edit: the offsets of its tokens
+// and their fingerprint. first is its first token, delta the change in
+// length of the input and kept is set when the block has the same tokens.
+typedef struct {
+  int *offsets;
+  int count;
+  unsigned long long fingerprint;
+  int first;
+  int delta;
+  int kept;
+} OldBlock;
+
+int getSubprogram(Object *obj, Subprogram *sub) {
+  switch (obj->kind) {
+  case OBJ_FUNCTION:
+    sub->firstToken = &obj->funcAttrs->firstToken;
+    sub->lastToken = &obj->funcAttrs->lastToken;
+    sub->bodyToken = &obj->funcAttrs->bodyToken;
+    sub->pending = &obj->funcAttrs->pending;
+    sub->body = &obj->funcAttrs->body;
+    sub->bodyOffset = &obj->funcAttrs->bodyOffset;
+    sub->scope = obj->funcAttrs->scope;
+    sub->paramList = obj->funcAttrs->paramList;
+    return 1;
+  case OBJ_PROCEDURE:
+    sub->firstToken = &obj->procAttrs->firstToken;
+    sub->lastToken = &obj->procAttrs->lastToken;
+    sub->bodyToken = &obj->procAttrs->bodyToken;
+    sub->pending = &obj->procAttrs->pending;
+    sub->body = &obj->procAttrs->body;
+    sub->bodyOffset = &obj->procAttrs->bodyOffset;
+    sub->scope = obj->procAttrs->scope;
+    sub->paramList = obj->procAttrs->paramList;
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// FNV-1a over the types and values of the tokens from first to last
+unsigned long long fingerprint(TokenBuffer *tokens, int first, int last) {
+  unsigned long long hash = FNV_OFFSET_BASIS;
+  int i;
+
+  for (i = first; i <= last; i++) {
+    hash = (hash ^ tokens->types[i]) * FNV_PRIME;
+    hash = (hash ^ (unsigned int) tokens->values[i]) * FNV_PRIME;
+  }
+  return hash;
+}
+
+// The innermost subprogram whose block holds the characters from start to
+// end, after its first token and up to its END
+Object* enclosingSubprogram(KplContext *ctx, int start, int end) {
+  TokenBuffer *tokens = ctx->tokens;
+  ObjectNode *list = ctx->symtab->program->progAttrs->scope->objList;
+  Object *found = NULL;
+  Subprogram sub;
+  int first, last;
+
+  while (list != NULL) {
+    if (getSubprogram(list->object, &sub) && (*sub.firstToken >= 0)) {
+      first = *sub.firstToken;
+      last = *sub.lastToken;
+      if ((tokens->offsets[first] + tokens->lengths[first] < start) && (end <= tokens->offsets[last])) {
+	found = list->object;
+	list = sub.scope->objList;
+	continue;
+      }
+    }
+    list = list->next;
+  }
+  return found;
+}
+
+// Where an offset from before the edit is now. One in the edited block is
+// that of the token of the same index, when the block is kept, and is
+// about to go otherwise.
+int movedOffset(TokenBuffer *tokens, OldBlock *old, int offset) {
+  int lo = 0, hi = old->count - 1;
+
+  if (offset < old->offsets[0])
+    return offset;
+  if (offset > old->offsets[old->count - 1])
+    return offset + old->delta;
+  if (!old->kept)
+    return offset;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (old->offsets[mid] < offset) lo = mid + 1;
+    else hi = mid;
+  }
+  return tokens->offsets[old->first + lo];
+}
+
+// Moves the token ranges that start or end at old index from or later by
+// delta entries, and the statement parts to where they are now
+void moveBlocks(KplContext *ctx, OldBlock *old, int from, int delta) {
+  SymTab *symtab = ctx->symtab;
+  Object *obj;
+  Subprogram sub;
+  int i;
+
+  for (i = 0; i < symtab->objectCount; i++) {
+    if ((obj = symtab->objects[i]) == NULL)
+      continue;
+    if (obj->kind == OBJ_PROGRAM)
+      obj->progAttrs->bodyOffset = movedOffset(ctx->tokens, old, obj->progAttrs->bodyOffset);
+    if (!getSubprogram(obj, &sub) || (*sub.firstToken < 0))
+      continue;
+    if (*sub.firstToken >= from)
+      *sub.firstToken += delta;
+    if (*sub.lastToken >= from)
+      *sub.lastToken += delta;
+    if (*sub.bodyToken >= from)
+      *sub.bodyToken += delta;
+    *sub.bodyOffset = movedOffset(ctx->tokens, old, *sub.bodyOffset);
+  }
+}
+
+// Moves the nodes of a tree from the statement part at from before the
+// edit to the one at to now
+void moveTree(KplContext *ctx, OldBlock *old, NodeId id, int from, int to) {
+  Ast *ast = ctx->ast;
+  Node *node;
+  int list, i;
+
+  if (id == NO_NODE)
+    return;
+  node = NODE(ast, id);
+  node->offset = movedOffset(ctx->tokens, old, node->offset + from) - to;
+
+  switch (node->kind) {
+  case N_NUMBER:
+  case N_CHAR:
+  case N_CONSTANT:
+  case N_VARIABLE:
+  case N_PARAMETER:
+    break;
+  case N_CALL:
+  case N_FUNCTION:
+  case N_GROUP:
+    list = (node->kind == N_GROUP) ? node->first : node->second;
+    for (; list != NO_LIST; list = LIST_NEXT(ast, list))
+      moveTree(ctx, old, LIST_NODE(ast, list), from, to);
+    break;
+  case N_IF:
+    moveTree(ctx, old, node->first, from, to);
+    moveTree(ctx, old, ast->extra[node->second], from, to);
+    moveTree(ctx, old, ast->extra[node->second + 1], from, to);
+    break;
+  case N_FOR:
+    for (i = 0; i < 3; i++)
+      moveTree(ctx, old, ast->extra[node->second + i], from, to);
+    break;
+  case N_NEGATE:
+    moveTree(ctx, old, node->first, from, to);
+    break;
+  default:
+    moveTree(ctx, old, node->first, from, to);
+    moveTree(ctx, old, node->second, from, to);
+    break;
+  }
+}
+
+void moveDiagnostics(KplContext *ctx, OldBlock *old) {
+  int i;
+
+  for (i = 0; i < ctx->diagnosticCount; i++)
+    ctx->diagnostics[i].offset = movedOffset(ctx->tokens, old, ctx->diagnostics[i].offset);
+}
+
+// Takes the diagnostics of the edited block out and returns where they
+// were, or would have been, in the list
+int removeDiagnostics(KplContext *ctx, OldBlock *old) {
+  int start = old->offsets[0], end = old->offsets[old->count - 1];
+  int at = -1, count = 0, i;
+  Diagnostic *diagnostic;
+
+  for (i = 0; i < ctx->diagnosticCount; i++) {
+    diagnostic = &ctx->diagnostics[i];
+    if ((diagnostic->offset >= start) && (diagnostic->offset <= end)) {
+      if (at < 0)
+	at = count;
+      continue;
+    }
+    if ((at < 0) && (diagnostic->offset > end))
+      at = count;
+    ctx->diagnostics[count ++] = *diagnostic;
+  }
+  ctx->diagnosticCount = count;
+  return (at < 0) ? count : at;
+}
+
+// Takes the objects of list, and those of their scopes, out of the object
+// table
+void forgetObjects(SymTab *symtab, ObjectNode *list) {
+  Subprogram sub;
+
+  for (; list != NULL; list = list->next) {
+    symtab->objects[list->object->index - symtab->objectBase] = NULL;
+    if (getSubprogram(list->object, &sub))
+      forgetObjects(symtab, sub.scope->objList);
+  }
+}
+
+// Forgets what the block of a subprogram declared; its parameters stay
+void dropDeclarations(SymTab *symtab, Subprogram *sub) {
+  ObjectNode **rest = &sub->scope->objList;
+  ObjectNode *param;
+
+  for (param = sub->paramList; param != NULL; param = param->next)
+    rest = &(*rest)->next;
+  forgetObjects(symtab, *rest);
+  freeObjectList(*rest);
+  *rest = NULL;
+}
+
+// error() comes back here. The block is only good when it ends at the END
+// it ended at before.
+int compileEditedBlock(KplContext *ctx, Subprogram *sub) {
+  if (setjmp(ctx->errorJump) != 0)
+    return 0;
+  scan(ctx);
+  *sub->body = compileBlock(ctx);
+  *sub->bodyOffset = ctx->ast->base;
+  return ctx->tokenIndex == *sub->lastToken + 2;
+}
+
+// Parses the block of a subprogram again, with its diagnostics going to a
+// list of their own that is put in at at. Together with the others they
+// must stay under maxErrors, for the parse of the program not to have
+// stopped.
+int reparseBlock(KplContext *ctx, Subprogram *sub, int at) {
+  int tokenIndex = ctx->tokenIndex;
+  Token currentToken = ctx->currentToken, lookAhead = ctx->lookAhead;
+  Scope *currentScope = ctx->symtab->currentScope;
+  Diagnostic *diagnostics = ctx->diagnostics;
+  int diagnosticCount = ctx->diagnosticCount;
+  int diagnosticCapacity = ctx->diagnosticCapacity;
+  int maxErrors = ctx->maxErrors;
+  Diagnostic *fresh;
+  int freshCount;
+  jmp_buf errorJump;
+  int parsed;
+
+  dropDeclarations(ctx->symtab, sub);
+  *sub->pending = 0;
+  memcpy(errorJump, ctx->errorJump, sizeof(jmp_buf));
+  ctx->diagnostics = NULL;
+  ctx->diagnosticCount = 0;
+  ctx->diagnosticCapacity = 0;
+  ctx->maxErrors = maxErrors - diagnosticCount;
+  ctx->recoveryJump = NULL;
+  ctx->tokenIndex = *sub->firstToken;
+  enterBlock(ctx, sub->scope);
+
+  parsed = compileEditedBlock(ctx, sub);
+
+  fresh = ctx->diagnostics;
+  freshCount = ctx->diagnosticCount;
+  memcpy(ctx->errorJump, errorJump, sizeof(jmp_buf));
+  ctx->diagnostics = diagnostics;
+  ctx->diagnosticCount = diagnosticCount;
+  ctx->diagnosticCapacity = diagnosticCapacity;
+  ctx->maxErrors = maxErrors;
+  ctx->recoveryJump = NULL;
+  ctx->symtab->currentScope = currentScope;
+  ctx->tokenIndex = tokenIndex;
+  ctx->currentToken = currentToken;
+  ctx->lookAhead = lookAhead;
+
+  if (parsed && (freshCount > 0)) {
+    if (diagnosticCount + freshCount > diagnosticCapacity) {
+      ctx->diagnosticCapacity = diagnosticCount + freshCount;
+      ctx->diagnostics = (Diagnostic*) realloc(diagnostics, ctx->diagnosticCapacity * sizeof(Diagnostic));
+    }
+    memmove(ctx->diagnostics + at + freshCount, ctx->diagnostics + at, (diagnosticCount - at) * sizeof(Diagnostic));
+    memcpy(ctx->diagnostics + at, fresh, freshCount * sizeof(Diagnostic));
+    ctx->diagnosticCount += freshCount;
+  }
+  free(fresh);
+  return parsed;
+}
+
+// A fresh parse has no more nodes than tokens, nor more objects
+int tooMuchGarbage(KplContext *ctx) {
+  return (ctx->ast->count > 2 * ctx->tokens->count) || (ctx->symtab->objectCount > 2 * ctx->tokens->count);
+}
+
+// A lazy parse that reports errors is done again with every body in place,
+// see parseInput(), which a block parsed again alone cannot follow
+int lazyWithErrors(KplContext *ctx) {
+  return ctx->lazyBodies && (ctx->diagnosticCount > 0);
+}
+
+void reparseProgram(KplContext *ctx) {
+  if (!ctx->syntaxOnly)
+    cleanSymTab(ctx);
+  freeAst(ctx->ast);
+  ctx->tokenIndex = 0;
+  parseInput(ctx);
+}
+
+// Applies an edit to the input of ctx, opened by openProgram() with
+// pretokenized input, and brings its tokens, tree, symbol table and
+// diagnostics up to date. kind tells what that took. An edit that is not
+// inside the input is refused, with nothing changed.
+int reparseEdit(KplContext *ctx, int start, int removed, char *text, int length, ReparseKind *kind) {
+  TokenBuffer *tokens = ctx->tokens;
+  Object *owner = NULL;
+  Subprogram sub;
+  OldBlock old;
+  TokenRange range;
+  int last = 0, from, delta, bodyOffset, at;
+
+  if ((tokens == NULL) || !editFits(ctx, start, removed, length))
+    return IO_ERROR;
+
+  // Only what a complete parse of the program left can be kept
+  old.offsets = NULL;
+  if (!ctx->syntaxOnly && !ctx->parseIncomplete && (ctx->symtab->program != NULL))
+    owner = enclosingSubprogram(ctx, start, start + removed);
+  if (owner != NULL) {
+    getSubprogram(owner, &sub);
+    old.first = *sub.firstToken;
+    last = *sub.lastToken;
+    old.count = last - old.first + 1;
+    old.offsets = (int*) malloc(old.count * sizeof(int));
+    memcpy(old.offsets, tokens->offsets + old.first, old.count * sizeof(int));
+    old.fingerprint = fingerprint(tokens, old.first, last);
+    old.delta = length - removed;
+  }
+
+  if (relexEdit(ctx, tokens, start, removed, text, length, &range) == IO_ERROR) {
+    free(old.offsets);
+    return IO_ERROR;
+  }
+
+  *kind = REPARSE_PROGRAM;
+  // The tokens replaced must be inside the block, and a lexical error ends
+  // the program
+  if ((owner != NULL) && (range.first > old.first) && (range.first + range.removedCount <= last) &&
+      (tokens->types[tokens->count - 1] != TK_NONE)) {
+    from = range.first + range.removedCount;
+    delta = range.insertedCount - range.removedCount;
+    last += delta;
+    old.kept = (last - old.first + 1 == old.count) && (fingerprint(tokens, old.first, last) == old.fingerprint);
+    bodyOffset = *sub.bodyOffset;
+    if (old.kept || (old.delta != 0) || (delta != 0))
+      moveBlocks(ctx, &old, from, delta);
+    // A statement part left for later is parsed from its tokens as they
+    // are when it is asked for, as long as they still end the block
+    if (old.kept || (*sub.pending && (range.first > *sub.bodyToken) && (skimStatements(tokens, *sub.bodyToken) == last))) {
+      if (old.kept)
+	moveTree(ctx, &old, *sub.body, bodyOffset, *sub.bodyOffset);
+      moveDiagnostics(ctx, &old);
+      *kind = REPARSE_NOTHING;
+    } else if (!tooMuchGarbage(ctx) && !lazyWithErrors(ctx)) {
+      at = removeDiagnostics(ctx, &old);
+      moveDiagnostics(ctx, &old);
+      if (reparseBlock(ctx, &sub, at) && !lazyWithErrors(ctx))
+	*kind = REPARSE_BODY;
+    }
+  }
+  free(old.offsets);
+
+  if (*kind == REPARSE_PROGRAM)
+    reparseProgram(ctx);
+  return IO_SUCCESS;
+}
@@ -0,0 +1,21 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __INCREMENTAL_H__
+#define __INCREMENTAL_H__
+
+#include "context.h"
+
+// What reparseEdit() had to do
+typedef enum {
+  REPARSE_NOTHING,   // the tokens of the edited block are the same
+  REPARSE_BODY,      // the edited block was parsed again
+  REPARSE_PROGRAM    // the whole program was parsed again
+} ReparseKind;
+
+int reparseEdit(KplContext *ctx, int start, int removed, char *text, int length, ReparseKind *kind);
+
+#endif
@@ -0,0 +1,128 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "interner.h"
+
+#define INITIAL_SLOTS 256
+
+Interner* createInterner(void) {
+  Interner *interner = (Interner*) calloc(1, sizeof(Interner));
+
+  interner->slotCount = INITIAL_SLOTS;
+  interner->slots = (int*) calloc(INITIAL_SLOTS, sizeof(int));
+  interner->capacity = INITIAL_SLOTS / 2;
+  interner->names = (char**) malloc(interner->capacity * sizeof(char*));
+  interner->hashes = (unsigned*) malloc(interner->capacity * sizeof(unsigned));
+  return interner;
+}
+
+void freeInterner(Interner *interner) {
+  struct NameBlock_ *block;
+
+  if (interner == NULL)
+    return;
+  while (interner->blocks != NULL) {
+    block = interner->blocks;
+    interner->blocks = block->next;
+    free(block);
+  }
+  free(interner->slots);
+  free(interner->names);
+  free(interner->hashes);
+  free(interner);
+}
+
+// FNV-1a over the upper case spelling
+unsigned hashName(char *string, int length) {
+  unsigned hash = 2166136261u;
+  int i;
+
+  for (i = 0; i < length; i++)
+    hash = (hash ^ (unsigned char) toupper((unsigned char) string[i])) * 16777619u;
+  return hash;
+}
+
+int sameName(char *name, char *string, int length) {
+  int i;
+
+  for (i = 0; i < length; i++)
+    if (name[i] != toupper((unsigned char) string[i]))
+      return 0;
+  return name[length] == '\0';
+}
+
+char* storeName(Interner *interner, char *string, int length) {
+  struct NameBlock_ *block = interner->blocks;
+  char *name;
+  int i;
+
+  if ((block == NULL) || (block->used + length + 1 > NAME_BLOCK_SIZE)) {
+    int size = (length + 1 > NAME_BLOCK_SIZE) ? length + 1 : NAME_BLOCK_SIZE;
+    block = (struct NameBlock_*) malloc(sizeof(struct NameBlock_) - NAME_BLOCK_SIZE + size);
+    block->used = 0;
+    block->next = interner->blocks;
+    interner->blocks = block;
+  }
+
+  name = block->chars + block->used;
+  for (i = 0; i < length; i++)
+    name[i] = toupper((unsigned char) string[i]);
+  name[length] = '\0';
+  block->used += length + 1;
+  return name;
+}
+
+// Keeps the table at most half full
+void growSlots(Interner *interner) {
+  int slotCount = interner->slotCount * 2;
+  int *slots = (int*) calloc(slotCount, sizeof(int));
+  int symbol, i;
+
+  for (symbol = 0; symbol < interner->symbolCount; symbol++) {
+    i = interner->hashes[symbol] & (slotCount - 1);
+    while (slots[i] != 0)
+      i = (i + 1) & (slotCount - 1);
+    slots[i] = symbol + 1;
+  }
+  free(interner->slots);
+  interner->slots = slots;
+  interner->slotCount = slotCount;
+
+  interner->capacity = slotCount / 2;
+  interner->names = (char**) realloc(interner->names, interner->capacity * sizeof(char*));
+  interner->hashes = (unsigned*) realloc(interner->hashes, interner->capacity * sizeof(unsigned));
+}
+
+int internName(Interner *interner, char *string, int length) {
+  unsigned hash = hashName(string, length);
+  int i = hash & (interner->slotCount - 1);
+  int symbol;
+
+  while (interner->slots[i] != 0) {
+    symbol = interner->slots[i] - 1;
+    if ((interner->hashes[symbol] == hash) && sameName(interner->names[symbol], string, length))
+      return symbol;
+    i = (i + 1) & (interner->slotCount - 1);
+  }
+
+  if (interner->symbolCount == interner->capacity) {
+    growSlots(interner);
+    return internName(interner, string, length);
+  }
+
+  symbol = interner->symbolCount ++;
+  interner->names[symbol] = storeName(interner, string, length);
+  interner->hashes[symbol] = hash;
+  interner->slots[i] = symbol + 1;
+  return symbol;
+}
+
+char* symbolName(Interner *interner, int symbol) {
+  return interner->names[symbol];
+}
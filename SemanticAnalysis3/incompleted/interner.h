@@ -0,0 +1,43 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __INTERNER_H__
+#define __INTERNER_H__
+
+// Maps every distinct identifier of a compilation to a dense symbol ID,
+// 0, 1, 2, ... in order of first appearance. Identifiers are not case
+// sensitive: the key is the upper case spelling, which is also the name
+// kept for each symbol. Names are never moved once stored, so the
+// pointers returned by symbolName stay valid until the interner is freed.
+
+#define NAME_BLOCK_SIZE 4096
+
+struct NameBlock_ {
+  struct NameBlock_ *next;
+  int used;
+  char chars[NAME_BLOCK_SIZE];
+};
+
+struct Interner_ {
+  // Open addressing table of symbol ID + 1, 0 when free
+  int *slots;
+  int slotCount;
+  // Per symbol
+  char **names;
+  unsigned *hashes;
+  int symbolCount;
+  int capacity;
+  struct NameBlock_ *blocks;
+};
+
+typedef struct Interner_ Interner;
+
+Interner* createInterner(void);
+void freeInterner(Interner *interner);
+int internName(Interner *interner, char *string, int length);
+char* symbolName(Interner *interner, int symbol);
+
+#endif
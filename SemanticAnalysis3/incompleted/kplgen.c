@@ -0,0 +1,483 @@
+/* KPL program generator
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Writes a valid KPL program of a chosen size and shape, for benchmarks.
+//
+// usage: kplgen [options] [-o file]
+//   -c n      constants in the program scope (default 20)
+//   -t n      array types in the program scope (default 5)
+//   -v n      variables in the program scope (default 50)
+//   -s n      subprograms in the program scope (default 10)
+//   -d n      nesting depth: every subprogram contains a chain of n - 1
+//             nested ones (default 1)
+//   -n n      statements in every body (default 20)
+//   -z bytes  keep adding statements to the main body up to this size
+//   -m a,c,i,w,f,g
+//             statement mix: weights of assignments, calls, IFs, WHILEs,
+//             FORs and BEGIN groups (default 6,2,2,1,1,1)
+//   -l n      identifier length, at least 6 (default 8)
+//   -k n      percentage of declarations and statements followed by a
+//             comment (default 10)
+//   -r seed   random seed (default 1)
+//   -S shape  adversarial presets, applied before the other options:
+//             wide  100000 variables in one scope, 1000 statements using
+//                   them
+//             deep  subprograms nested 1000 deep, each body using the
+//                   variables of the program scope
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#define MIN_IDENT_LEN 6
+#define MAX_STATEMENT_DEPTH 3
+#define MAX_EXPRESSION_TERMS 3
+#define ARRAY_SIZE 10
+
+enum StatementKind {
+  ST_ASSIGN, ST_CALL, ST_IF, ST_WHILE, ST_FOR, ST_GROUP, ST_KIND_COUNT
+};
+
+struct Options {
+  int constants, types, variables, subprograms, depth, statements;
+  long size;
+  int mix[ST_KIND_COUNT];
+  int identLength, commentPercent;
+  unsigned seed;
+};
+
+struct Options options = {
+  20, 5, 50, 10, 1, 20, 0,
+  { 6, 2, 2, 1, 1, 1 },
+  8, 10, 1
+};
+
+FILE *out;
+long written = 0;
+int indent = 0;
+
+// Names: a kind letter and a serial number padded with zeros to the
+// identifier length, unique over the whole program
+int serial = 0;
+
+// What a body can use: integer variables, integer parameters, array
+// variables, integer constants, procedures and functions
+struct Names {
+  int *ints, intCount;
+  int *params, paramCount;
+  int *arrays, arrayCount;
+  int *consts, constCount;
+  int *procs, procCount;
+  int *funcs, funcCount;
+};
+
+struct Names globals;
+
+void emit(char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  written += vfprintf(out, format, args);
+  va_end(args);
+}
+
+void newLine(void) {
+  int i;
+  emit("\n");
+  for (i = 0; i < indent; i++)
+    emit("  ");
+}
+
+void emitName(char kind, int number) {
+  int digits = options.identLength - 1;
+  emit("%c%0*d", kind, digits, number);
+}
+
+void maybeComment(void) {
+  if (rand() % 100 < options.commentPercent)
+    emit(" (* generated %d *)", rand() % 1000);
+}
+
+int pick(int *list, int count) {
+  return list[rand() % count];
+}
+
+int* append(int *list, int *count, int value) {
+  list = (int*) realloc(list, (*count + 1) * sizeof(int));
+  list[(*count)++] = value;
+  return list;
+}
+
+/******************************************************************/
+
+void emitExpression(struct Names *names, int depth);
+
+void emitFactor(struct Names *names, int depth) {
+  int choice = rand() % 5;
+
+  if ((choice == 1) && (names->paramCount > 0) && (rand() % 4 == 0))
+    emitName('X', pick(names->params, names->paramCount));
+  else if ((choice == 1) && (names->intCount > 0))
+    emitName('V', pick(names->ints, names->intCount));
+  else if ((choice == 2) && (names->constCount > 0))
+    emitName('C', pick(names->consts, names->constCount));
+  else if ((choice == 3) && (names->arrayCount > 0) && (depth < 2)) {
+    emitName('A', pick(names->arrays, names->arrayCount));
+    emit("(. %d .)", rand() % ARRAY_SIZE);
+  } else if ((choice == 4) && (names->funcCount > 0) && (depth < 2)) {
+    emitName('F', pick(names->funcs, names->funcCount));
+    emit("(");
+    emitExpression(names, depth + 1);
+    emit(")");
+  } else emit("%d", rand() % 1000);
+}
+
+void emitExpression(struct Names *names, int depth) {
+  int terms = 1 + rand() % MAX_EXPRESSION_TERMS;
+  int i;
+
+  emitFactor(names, depth);
+  for (i = 1; i < terms; i++) {
+    emit(" %c ", "+-*/"[rand() % 4]);
+    emitFactor(names, depth);
+  }
+}
+
+void emitCondition(struct Names *names) {
+  static char *comparators[] = { "=", "!=", "<", "<=", ">", ">=" };
+
+  emitExpression(names, 0);
+  emit(" %s ", comparators[rand() % 6]);
+  emitExpression(names, 0);
+}
+
+enum StatementKind pickStatement(int depth) {
+  int total = 0, i, r;
+
+  for (i = 0; i < ST_KIND_COUNT; i++)
+    total += options.mix[i];
+  if (total == 0)
+    return ST_ASSIGN;
+  r = rand() % total;
+  for (i = 0; r >= options.mix[i]; i++)
+    r -= options.mix[i];
+  // Nesting is bounded: deep statements are simple
+  if ((depth >= MAX_STATEMENT_DEPTH) && (i != ST_CALL))
+    return ST_ASSIGN;
+  return i;
+}
+
+void emitStatements(struct Names *names, int count, int depth);
+
+void emitStatement(struct Names *names, int depth) {
+  switch (pickStatement(depth)) {
+  case ST_ASSIGN:
+    if ((names->arrayCount > 0) && (rand() % 4 == 0)) {
+      emitName('A', pick(names->arrays, names->arrayCount));
+      emit("(. %d .)", rand() % ARRAY_SIZE);
+    } else if ((names->paramCount > 0) && (rand() % 4 == 0))
+      emitName('X', pick(names->params, names->paramCount));
+    else emitName('V', pick(names->ints, names->intCount));
+    emit(" := ");
+    emitExpression(names, 0);
+    break;
+  case ST_CALL:
+    emit("CALL ");
+    if ((names->procCount > 0) && (rand() % 2 == 0)) {
+      emitName('P', pick(names->procs, names->procCount));
+      emit("(");
+      emitExpression(names, 0);
+      emit(", ");
+      emitName('V', pick(names->ints, names->intCount));
+      emit(")");
+    } else {
+      emit("WRITEI(");
+      emitExpression(names, 0);
+      emit(")");
+    }
+    break;
+  case ST_IF:
+    emit("IF ");
+    emitCondition(names);
+    emit(" THEN ");
+    emitStatement(names, depth + 1);
+    if (rand() % 2) {
+      emit(" ELSE ");
+      emitStatement(names, depth + 1);
+    }
+    break;
+  case ST_WHILE:
+    emit("WHILE ");
+    emitCondition(names);
+    emit(" DO ");
+    emitStatement(names, depth + 1);
+    break;
+  case ST_FOR:
+    emit("FOR ");
+    emitName('V', pick(names->ints, names->intCount));
+    emit(" := 1 TO %d DO ", 1 + rand() % 10);
+    emitStatement(names, depth + 1);
+    break;
+  case ST_GROUP:
+    emit("BEGIN");
+    indent ++;
+    emitStatements(names, 1 + rand() % 3, depth + 1);
+    indent --;
+    newLine();
+    emit("END");
+    break;
+  default:
+    break;
+  }
+}
+
+// Every statement ends with a semicolon: before END, it is followed by
+// an empty statement
+void emitStatements(struct Names *names, int count, int depth) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    newLine();
+    emitStatement(names, depth);
+    emit(";");
+    maybeComment();
+  }
+}
+
+/******************************************************************/
+
+void emitBlock(struct Names *names, int constants, int types, int variables, int subprograms, int depth, int main);
+
+// A procedure P(X : INTEGER; VAR Y : INTEGER) or a function
+// F(X : INTEGER) : INTEGER, with its block
+void emitSubprogram(struct Names *outer, int depth) {
+  struct Names names = *outer;
+  int isFunction = rand() % 2;
+  int number = serial ++;
+  int param = serial ++;
+  int result = serial ++;
+
+  // Own copies of the lists, so that nested declarations stay local
+  names.ints = (int*) malloc((outer->intCount + 1) * sizeof(int));
+  memcpy(names.ints, outer->ints, outer->intCount * sizeof(int));
+  names.params = (int*) malloc((outer->paramCount + 2) * sizeof(int));
+  memcpy(names.params, outer->params, outer->paramCount * sizeof(int));
+  names.procs = (int*) malloc((outer->procCount + 1) * sizeof(int));
+  memcpy(names.procs, outer->procs, outer->procCount * sizeof(int));
+  names.funcs = (int*) malloc((outer->funcCount + 1) * sizeof(int));
+  memcpy(names.funcs, outer->funcs, outer->funcCount * sizeof(int));
+
+  newLine();
+  if (isFunction) {
+    emit("FUNCTION ");
+    emitName('F', number);
+    emit("(");
+    emitName('X', param);
+    emit(" : INTEGER) : INTEGER;");
+  } else {
+    emit("PROCEDURE ");
+    emitName('P', number);
+    emit("(");
+    emitName('X', param);
+    emit(" : INTEGER; VAR ");
+    emitName('X', result);
+    emit(" : INTEGER);");
+    names.params[names.paramCount++] = result;
+  }
+  names.params[names.paramCount++] = param;
+  maybeComment();
+
+  indent ++;
+  emitBlock(&names, 0, 0, 2, (depth > 1) ? 1 : 0, depth - 1, 0);
+  if (isFunction) {
+    // The function returns through its name
+    newLine();
+    emitName('F', number);
+    emit(" := ");
+    emitExpression(&names, 0);
+  }
+  indent --;
+  newLine();
+  emit("END;");
+  indent --;
+
+  if (isFunction)
+    outer->funcs = append(outer->funcs, &outer->funcCount, number);
+  else outer->procs = append(outer->procs, &outer->procCount, number);
+  free(names.ints);
+  free(names.params);
+  free(names.procs);
+  free(names.funcs);
+}
+
+// Declarations, subprograms and the body, up to its END
+void emitBlock(struct Names *names, int constants, int types, int variables, int subprograms, int depth, int main) {
+  int *arrayTypes = NULL, arrayTypeCount = 0;
+  int i, number;
+
+  if (constants > 0) {
+    newLine();
+    emit("CONST");
+    indent ++;
+    for (i = 0; i < constants; i++) {
+      number = serial ++;
+      newLine();
+      emitName('C', number);
+      emit(" = %d;", rand() % 1000);
+      maybeComment();
+      names->consts = append(names->consts, &names->constCount, number);
+    }
+    indent --;
+  }
+
+  if (types > 0) {
+    newLine();
+    emit("TYPE");
+    indent ++;
+    for (i = 0; i < types; i++) {
+      number = serial ++;
+      newLine();
+      emitName('T', number);
+      emit(" = ARRAY(. %d .) OF INTEGER;", ARRAY_SIZE);
+      maybeComment();
+      arrayTypes = append(arrayTypes, &arrayTypeCount, number);
+    }
+    indent --;
+  }
+
+  if (variables > 0) {
+    newLine();
+    emit("VAR");
+    indent ++;
+    for (i = 0; i < variables; i++) {
+      number = serial ++;
+      newLine();
+      if ((arrayTypeCount > 0) && (i % 5 == 4)) {
+	emitName('A', number);
+	emit(" : ");
+	emitName('T', pick(arrayTypes, arrayTypeCount));
+	emit(";");
+	names->arrays = append(names->arrays, &names->arrayCount, number);
+      } else {
+	emitName('V', number);
+	emit(" : INTEGER;");
+	names->ints = append(names->ints, &names->intCount, number);
+      }
+      maybeComment();
+    }
+    indent --;
+  }
+  free(arrayTypes);
+
+  for (i = 0; i < subprograms; i++)
+    emitSubprogram(names, depth);
+
+  // Bodies need an integer to work on
+  if (names->intCount == 0) {
+    fprintf(stderr, "kplgen: no variables to use in the statements\n");
+    exit(1);
+  }
+
+  newLine();
+  emit("BEGIN");
+  indent ++;
+  emitStatements(names, options.statements, 0);
+  if (main)
+    while (written < options.size)
+      emitStatements(names, 1, 0);
+}
+
+/******************************************************************/
+
+void applyShape(char *shape) {
+  if (strcmp(shape, "wide") == 0) {
+    options.constants = 0;
+    options.types = 0;
+    options.variables = 100000;
+    options.subprograms = 0;
+    options.statements = 1000;
+  } else if (strcmp(shape, "deep") == 0) {
+    options.subprograms = 1;
+    options.depth = 1000;
+    options.statements = 2;
+    options.mix[ST_CALL] = 0;
+  } else {
+    fprintf(stderr, "kplgen: unknown shape %s\n", shape);
+    exit(1);
+  }
+}
+
+void usage(void) {
+  fprintf(stderr, "usage: kplgen [-c n] [-t n] [-v n] [-s n] [-d n] [-n n] [-z bytes]\n"
+	  "              [-m a,c,i,w,f,g] [-l n] [-k n] [-r seed] [-S wide|deep] [-o file]\n");
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  char *outName = NULL;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    if ((strcmp(argv[i], "-S") == 0) && (i + 1 < argc))
+      applyShape(argv[i + 1]);
+
+  for (i = 1; i < argc; i++) {
+    char *arg = argv[i];
+    char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if ((arg[0] != '-') || (arg[1] == '\0') || (arg[2] != '\0') || (value == NULL))
+      usage();
+    switch (arg[1]) {
+    case 'c': options.constants = atoi(value); break;
+    case 't': options.types = atoi(value); break;
+    case 'v': options.variables = atoi(value); break;
+    case 's': options.subprograms = atoi(value); break;
+    case 'd': options.depth = atoi(value); break;
+    case 'n': options.statements = atoi(value); break;
+    case 'z': options.size = atol(value); break;
+    case 'm':
+      if (sscanf(value, "%d,%d,%d,%d,%d,%d", &options.mix[0], &options.mix[1], &options.mix[2],
+		 &options.mix[3], &options.mix[4], &options.mix[5]) != ST_KIND_COUNT)
+	usage();
+      break;
+    case 'l': options.identLength = atoi(value); break;
+    case 'k': options.commentPercent = atoi(value); break;
+    case 'r': options.seed = atoi(value); break;
+    case 'S': break;
+    case 'o': outName = value; break;
+    default: usage();
+    }
+    i ++;
+  }
+
+  if (options.identLength < MIN_IDENT_LEN)
+    options.identLength = MIN_IDENT_LEN;
+  if (options.depth < 1)
+    options.depth = 1;
+  if (options.statements < 1)
+    options.statements = 1;
+
+  out = stdout;
+  if ((outName != NULL) && ((out = fopen(outName, "w")) == NULL)) {
+    fprintf(stderr, "kplgen: can't write %s\n", outName);
+    return 1;
+  }
+  srand(options.seed);
+
+  emit("PROGRAM ");
+  emitName('G', serial ++);
+  emit(";");
+  maybeComment();
+  emitBlock(&globals, options.constants, options.types, options.variables,
+	    options.subprograms, options.depth, 1);
+  indent --;
+  newLine();
+  emit("END.\n");
+
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
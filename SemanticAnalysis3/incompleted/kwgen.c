@@ -0,0 +1,88 @@
+/* Keyword hash generator
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Searches a collision-free hash over the keywords of keywords.def and
+// prints the table used by checkKeyword() in token.c. The hash only looks
+// at the length and at the first and last characters of a word, folded to
+// upper case, so a keyword is recognized with one probe and one compare.
+
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_TABLE_SIZE 256
+#define MAX_MULTIPLIER 32
+
+struct {
+  char *string;
+  char *tokenType;
+} keywords[] = {
+#define KEYWORD(string, tokenType) {string, #tokenType},
+#include "keywords.def"
+#undef KEYWORD
+};
+
+int keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+int slots[MAX_TABLE_SIZE];
+
+int hash(char *kw, int a, int b, int c, int mask) {
+  int length = strlen(kw);
+  return (length * a + kw[0] * b + kw[length - 1] * c) & mask;
+}
+
+// Tries every multiplier triple for the given table size
+int search(int size, int *a, int *b, int *c) {
+  int i, h;
+
+  for (*a = 1; *a < MAX_MULTIPLIER; (*a)++)
+    for (*b = 1; *b < MAX_MULTIPLIER; (*b)++)
+      for (*c = 1; *c < MAX_MULTIPLIER; (*c)++) {
+	for (h = 0; h < size; h++) slots[h] = -1;
+	for (i = 0; i < keywordCount; i++) {
+	  h = hash(keywords[i].string, *a, *b, *c, size - 1);
+	  if (slots[h] >= 0) break;
+	  slots[h] = i;
+	}
+	if (i == keywordCount) return 1;
+      }
+  return 0;
+}
+
+int main(void) {
+  int size, a, b, c, h, length;
+  int minLength = 1000, maxLength = 0;
+
+  for (size = 1; size < keywordCount; size *= 2);
+  while ((size <= MAX_TABLE_SIZE) && !search(size, &a, &b, &c))
+    size *= 2;
+  if (size > MAX_TABLE_SIZE) {
+    fprintf(stderr, "kwgen: no perfect hash found\n");
+    return 1;
+  }
+
+  for (h = 0; h < keywordCount; h++) {
+    length = strlen(keywords[h].string);
+    if (length < minLength) minLength = length;
+    if (length > maxLength) maxLength = length;
+  }
+
+  printf("/* Generated by kwgen from keywords.def. Do not edit. */\n\n");
+  printf("#define KW_MIN_LEN %d\n", minLength);
+  printf("#define KW_MAX_LEN %d\n", maxLength);
+  printf("#define KW_HASH(length, first, last) (((length) * %d + (first) * %d + (last) * %d) & %d)\n\n",
+	 a, b, c, size - 1);
+  printf("struct KeywordEntry {\n  char string[KW_MAX_LEN + 1];\n  int length;\n  TokenType tokenType;\n};\n\n");
+  printf("struct KeywordEntry keywordTable[%d] = {\n", size);
+  for (h = 0; h < size; h++) {
+    if (slots[h] < 0)
+      printf("  {\"\", 0, TK_NONE}");
+    else
+      printf("  {\"%s\", %d, %s}", keywords[slots[h]].string,
+	     (int) strlen(keywords[slots[h]].string), keywords[slots[h]].tokenType);
+    printf(h < size - 1 ? ",\n" : "\n");
+  }
+  printf("};\n");
+  return 0;
+}
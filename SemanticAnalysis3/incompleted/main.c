@@ -6,22 +6,81 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "reader.h"
 #include "parser.h"
 
 /******************************************************************/
 
+// usage: kplc [options] file
+//   --dfa          scan with the table-driven engine
+//   --pretokenize  scan the whole file before parsing it
+//   --threads n    pretokenize large files on n threads
+//   --parse-threads n
+//                  pretokenize and parse the subprogram bodies on n threads
+//   --token-cache  pretokenize through file.kpltok, made on the first run
+//   --lazy         pretokenize and parse the statement parts of the
+//                  subprograms only when needed: unless with --ast, the
+//                  declarations alone, printed as such, with the bodies
+//                  left unchecked
+//   --ll1          pretokenize and parse with the table-driven LL(1)
+//                  parser, which takes no --lazy or --parse-threads
+//   --ast          print the statement parts as trees
+//   --max-errors n stop after n errors, 20 by default
+//   --syntax-only  only check the grammar: print the errors, if any, and
+//                  exit with 1 when there are some
 int main(int argc, char *argv[]) {
-  if (argc <= 1) {
+  KplContext *ctx;
+  char *fileName = NULL;
+  int result, failed, i;
+
+  ctx = createContext();
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--dfa") == 0)
+      ctx->dfaScanner = 1;
+    else if (strcmp(argv[i], "--pretokenize") == 0)
+      ctx->preTokenize = 1;
+    else if (strcmp(argv[i], "--lazy") == 0) {
+      ctx->preTokenize = 1;
+      ctx->lazyBodies = 1;
+    } else if (strcmp(argv[i], "--ll1") == 0) {
+      ctx->preTokenize = 1;
+      ctx->tableParser = 1;
+    } else if (strcmp(argv[i], "--ast") == 0)
+      ctx->printAst = 1;
+    else if (strcmp(argv[i], "--syntax-only") == 0)
+      ctx->syntaxOnly = 1;
+    else if (strcmp(argv[i], "--token-cache") == 0) {
+      ctx->preTokenize = 1;
+      ctx->tokenCache = 1;
+    } else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc)) {
+      ctx->preTokenize = 1;
+      ctx->scanThreads = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--parse-threads") == 0) && (i + 1 < argc)) {
+      ctx->preTokenize = 1;
+      ctx->parseThreads = atoi(argv[++i]);
+    } else if ((strcmp(argv[i], "--max-errors") == 0) && (i + 1 < argc)) {
+      ctx->maxErrors = atoi(argv[++i]);
+      if (ctx->maxErrors < 1)
+	ctx->maxErrors = 1;
+    } else fileName = argv[i];
+  }
+
+  if (fileName == NULL) {
     printf("parser: no input file.\n");
+    freeContext(ctx);
     return -1;
   }
 
-  if (compile(argv[1]) == IO_ERROR) {
+  result = compile(ctx, fileName);
+  failed = ctx->syntaxOnly && (ctx->diagnosticCount > 0);
+  freeContext(ctx);
+
+  if (result == IO_ERROR) {
     printf("Can\'t read input file!\n");
     return -1;
   }
     
-  return 0;
+  return failed ? 1 : 0;
 }
@@ -0,0 +1,217 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Multi-threaded parsing of the subprogram bodies of a program.
+//
+// While the declarations of the program are parsed, the block of each of
+// its subprograms is only skimmed: every FUNCTION or PROCEDURE opens a
+// block, which the END of its statement part closes, found by balancing
+// BEGIN and END. The headers are compiled as usual, so once the last
+// subprogram is declared the scope of the program is complete and no
+// longer changes.
+//
+// The bodies are then parsed and checked by a pool of threads, each with
+// a context of its own: a private cursor in the token buffer, symbol
+// table view, tree and diagnostics. They share the declarations of the
+// program read-only, and see them only up to their own subprogram, as
+// they would have in a sequential parse.
+//
+// The trees and the objects of the bodies are joined to those of the
+// program in source order. Error recovery does not stop at the end of a
+// body, so a body that fails is not joined: the program is compiled again
+// sequentially, to report exactly the errors it would have.
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "parallelparse.h"
+#include "parser.h"
+
+#define MIN_QUEUE_CAPACITY 64
+
+BodyQueue* createBodyQueue(void) {
+  BodyQueue *queue = (BodyQueue*) malloc(sizeof(BodyQueue));
+
+  queue->bodies = NULL;
+  queue->count = 0;
+  queue->capacity = 0;
+  queue->failed = 0;
+  queue->ctx = NULL;
+  queue->next = 0;
+  pthread_mutex_init(&queue->lock, NULL);
+  return queue;
+}
+
+void freeBodyQueue(BodyQueue *queue) {
+  int i;
+
+  if (queue == NULL)
+    return;
+  for (i = 0; i < queue->count; i++) {
+    freeAst(queue->bodies[i].ast);
+    free(queue->bodies[i].objects);
+  }
+  pthread_mutex_destroy(&queue->lock);
+  free(queue->bodies);
+  free(queue);
+}
+
+Scope* bodyScope(Object *owner) {
+  return (owner->kind == OBJ_FUNCTION) ? owner->funcAttrs->scope : owner->procAttrs->scope;
+}
+
+// Called in place of compileBlock() for the block of owner, whose
+// header has just been compiled. When owner is a subprogram of the
+// program and its block can be skimmed, the block is skipped up to its
+// END, left to parseDeferredBodies() and 1 is returned.
+int deferBody(KplContext *ctx, Object *owner, NodeId *body) {
+  BodyQueue *queue = ctx->bodyQueue;
+  struct DeferredBody *deferred;
+  int first = ctx->tokenIndex - 1, last;
+
+  if (bodyScope(owner)->outer != ctx->symtab->program->progAttrs->scope)
+    return 0;
+  if ((last = skimBlock(ctx)) < 0)
+    return 0;
+
+  if (queue->count == queue->capacity) {
+    queue->capacity = (queue->capacity == 0) ? MIN_QUEUE_CAPACITY : 2 * queue->capacity;
+    queue->bodies = (struct DeferredBody*) realloc(queue->bodies, queue->capacity * sizeof(struct DeferredBody));
+  }
+  deferred = &queue->bodies[queue->count ++];
+  deferred->owner = owner;
+  deferred->body = body;
+  deferred->first = first;
+  deferred->last = last;
+  deferred->ast = NULL;
+  deferred->root = NO_NODE;
+  deferred->objects = NULL;
+  deferred->objectCount = 0;
+  deferred->failed = 0;
+  *body = NO_NODE;
+
+  skipToToken(ctx, last);
+  return 1;
+}
+
+// The first error comes back here and fails the body
+void compileDeferredBody(KplContext *body, struct DeferredBody *deferred) {
+  deferred->failed = 1;
+  if (setjmp(body->errorJump) == 0) {
+    scan(body);
+    deferred->root = compileBlock(body);
+    deferred->bodyOffset = body->ast->base;
+    // The block must end at the END found by skimBlock()
+    deferred->failed = (body->diagnosticCount > 0) || (body->tokenIndex != deferred->last + 2);
+  }
+}
+
+// Parses a body in a context of its own
+void parseBody(BodyQueue *queue, struct DeferredBody *deferred) {
+  KplContext *ctx = queue->ctx;
+  KplContext body = *ctx;
+  SymTab symtab = *ctx->symtab;
+
+  symtab.currentScope = bodyScope(deferred->owner);
+  symtab.objects = NULL;
+  symtab.objectCount = 0;
+  symtab.objectCapacity = 0;
+  symtab.objectBase = ctx->symtab->objectCount;
+  body.symtab = &symtab;
+  body.ast = createAst(deferred->last - deferred->first + 1);
+  body.bodyQueue = NULL;
+  body.recoveryJump = NULL;
+  body.diagnostics = NULL;
+  body.diagnosticCount = 0;
+  body.diagnosticCapacity = 0;
+  body.maxErrors = 1;
+  body.tokenIndex = deferred->first;
+
+  compileDeferredBody(&body, deferred);
+  deferred->ast = body.ast;
+  deferred->objects = symtab.objects;
+  deferred->objectCount = symtab.objectCount;
+  free(body.diagnostics);
+}
+
+void* parseBodies(void *arg) {
+  BodyQueue *queue = (BodyQueue*) arg;
+  int i;
+
+  for (;;) {
+    pthread_mutex_lock(&queue->lock);
+    i = queue->next ++;
+    pthread_mutex_unlock(&queue->lock);
+    if (i >= queue->count)
+      break;
+    parseBody(queue, &queue->bodies[i]);
+  }
+  return NULL;
+}
+
+// Gives the objects of a body their place in the object table and moves
+// its tree into the program's. firstObject is where the objects of the
+// bodies were numbered from.
+void joinBody(KplContext *ctx, struct DeferredBody *deferred, int firstObject) {
+  int objectShift = ctx->symtab->objectCount - firstObject;
+  int nodeShift, i;
+  Object *obj;
+
+  for (i = 0; i < deferred->objectCount; i++)
+    numberObject(ctx, deferred->objects[i]);
+  nodeShift = appendAst(ctx->ast, deferred->ast, firstObject, objectShift);
+
+  for (i = 0; i < deferred->objectCount; i++) {
+    obj = deferred->objects[i];
+    if ((obj->kind == OBJ_FUNCTION) && (obj->funcAttrs->body != NO_NODE))
+      obj->funcAttrs->body += nodeShift;
+    else if ((obj->kind == OBJ_PROCEDURE) && (obj->procAttrs->body != NO_NODE))
+      obj->procAttrs->body += nodeShift;
+  }
+  *deferred->body = deferred->root + nodeShift;
+  if (deferred->owner->kind == OBJ_FUNCTION)
+    deferred->owner->funcAttrs->bodyOffset = deferred->bodyOffset;
+  else deferred->owner->procAttrs->bodyOffset = deferred->bodyOffset;
+}
+
+// Called at the end of the subprograms of the program
+void parseDeferredBodies(KplContext *ctx) {
+  BodyQueue *queue = ctx->bodyQueue;
+  int threadCount = ctx->parseThreads;
+  int firstObject = ctx->symtab->objectCount;
+  pthread_t *threads;
+  int i;
+
+  if (queue->count == 0)
+    return;
+  // The program is compiled again anyway
+  if (ctx->diagnosticCount > 0) {
+    queue->failed = 1;
+    return;
+  }
+
+  if (threadCount > queue->count)
+    threadCount = queue->count;
+  threads = (pthread_t*) malloc(threadCount * sizeof(pthread_t));
+  queue->ctx = ctx;
+  queue->next = 0;
+  for (i = 1; i < threadCount; i++)
+    pthread_create(&threads[i], NULL, parseBodies, queue);
+  parseBodies(queue);
+  for (i = 1; i < threadCount; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+
+  for (i = 0; i < queue->count; i++) {
+    if (queue->bodies[i].failed)
+      queue->failed = 1;
+    else joinBody(ctx, &queue->bodies[i], firstObject);
+    freeAst(queue->bodies[i].ast);
+    free(queue->bodies[i].objects);
+    queue->bodies[i].ast = NULL;
+    queue->bodies[i].objects = NULL;
+  }
+}
@@ -0,0 +1,54 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __PARALLELPARSE_H__
+#define __PARALLELPARSE_H__
+
+#include <pthread.h>
+
+#include "context.h"
+#include "symtab.h"
+
+// A subprogram body left for later: the tokens from first to last, the
+// END of its statement part
+struct DeferredBody {
+  Object *owner;
+  NodeId *body;
+  int first, last;
+
+  // What parsing it on its own gave: a tree, the objects it declared,
+  // numbered from the end of the program's table, and whether it failed
+  Ast *ast;
+  NodeId root;
+  int bodyOffset;
+  Object **objects;
+  int objectCount;
+  int failed;
+};
+
+// The bodies deferred in the block of the program, in source order.
+// failed is set when one of them could not be parsed on its own, and then
+// the program has to be compiled again sequentially.
+struct BodyQueue_ {
+  struct DeferredBody *bodies;
+  int count;
+  int capacity;
+  int failed;
+
+  // Shared by the threads while the bodies are parsed
+  KplContext *ctx;
+  int next;
+  pthread_mutex_t lock;
+};
+
+typedef struct BodyQueue_ BodyQueue;
+
+BodyQueue* createBodyQueue(void);
+void freeBodyQueue(BodyQueue *queue);
+int deferBody(KplContext *ctx, Object *owner, NodeId *body);
+void parseDeferredBodies(KplContext *ctx);
+
+#endif
@@ -0,0 +1,183 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Multi-threaded scanning of a whole file into a TokenBuffer.
+//
+// The input is cut into equal chunks, each scanned by its own thread from
+// its first byte as if a token started there. That guess is wrong when
+// the cut falls inside a token, a comment or a char constant, so these
+// streams are only speculative: lexical errors are recorded and scanning
+// goes on from the next character.
+//
+// The streams are then stitched in order by a sequential scanner that
+// knows the true state. The scanner is a function of the position only,
+// so as soon as it produces a token at the offset of a token in the
+// speculative stream, the rest of that stream up to its first error is
+// exactly what it would have produced: it is copied, and the sequential
+// scanner resumes after it in the next chunk. Only the few tokens around
+// each cut are scanned twice.
+//
+// The interner is not shared with the threads: identifiers get their
+// symbol IDs while being stitched, in stream order, so the IDs are those
+// of a sequential scan.
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "reader.h"
+#include "scanner.h"
+#include "parallelscan.h"
+#include "interner.h"
+
+struct LexChunk {
+  KplContext ctx;
+  int start, end;
+  TokenBuffer *tokens;
+  pthread_t thread;
+};
+
+// A private scanner over the shared input: own position and error jump,
+// and no interner
+void forkScanner(KplContext *ctx, KplContext *scanner, int offset) {
+  *scanner = *ctx;
+  scanner->interner = NULL;
+  scanner->recordErrors = 1;
+  scanner->inputPtr = scanner->inputBuffer + offset;
+  readChar(scanner);
+}
+
+// Scans the tokens that start inside the chunk
+void* scanChunk(void *arg) {
+  struct LexChunk *chunk = (struct LexChunk*) arg;
+  KplContext *ctx = &chunk->ctx;
+  int size = ctx->inputEnd - ctx->inputBuffer;
+  TokenType tokenType;
+  int offset, length, value;
+
+  chunk->tokens = createTokenBuffer((chunk->end - chunk->start) / 4);
+  for (;;) {
+    scanOne(ctx, &tokenType, &offset, &length, &value);
+    if (offset >= chunk->end)
+      break;
+    appendToken(chunk->tokens, tokenType, offset, length, value);
+    if (tokenType == TK_EOF)
+      break;
+    if (tokenType == TK_NONE) {
+      if (offset >= size)
+	break;
+      ctx->inputPtr = ctx->inputBuffer + offset + 1;
+      readChar(ctx);
+    }
+  }
+  return NULL;
+}
+
+void appendStitched(KplContext *ctx, TokenBuffer *to, TokenType tokenType, int offset, int length, int value) {
+  if ((tokenType == TK_IDENT) && (ctx->interner != NULL))
+    value = internName(ctx->interner, ctx->inputBuffer + offset, length);
+  appendToken(to, tokenType, offset, length, value);
+}
+
+void copyTokens(KplContext *ctx, TokenBuffer *to, TokenBuffer *from, int first, int last) {
+  int i;
+
+  for (i = first; i <= last; i++)
+    appendStitched(ctx, to, from->types[i], from->offsets[i], from->lengths[i], from->values[i]);
+}
+
+TokenBuffer* stitchChunks(KplContext *ctx, struct LexChunk *chunks, int chunkCount) {
+  TokenBuffer *result;
+  TokenBuffer *speculative;
+  KplContext scanner;
+  TokenType tokenType = TK_NONE;
+  int offset = 0, length = 0, value = 0;
+  int pending = 0, done = 0;
+  int i, j, k, total = 0;
+
+  for (i = 0; i < chunkCount; i++)
+    total += chunks[i].tokens->count;
+  result = createTokenBuffer(total);
+  forkScanner(ctx, &scanner, 0);
+
+  for (i = 0; (i < chunkCount) && !done; i++) {
+    speculative = chunks[i].tokens;
+    j = 0;
+    for (;;) {
+      if (!pending)
+	scanOne(&scanner, &tokenType, &offset, &length, &value);
+      pending = 1;
+
+      if ((tokenType != TK_NONE) && (offset >= chunks[i].end))
+	break;
+
+      while ((j < speculative->count) && (speculative->offsets[j] < offset))
+	j ++;
+      if ((tokenType != TK_NONE) && (j < speculative->count) &&
+	  (speculative->offsets[j] == offset) && (speculative->types[j] != TK_NONE)) {
+	// In step: take the rest of the chunk, up to its first error
+	for (k = j; (k < speculative->count) && (speculative->types[k] != TK_NONE); k++);
+	if (k < speculative->count) {
+	  copyTokens(ctx, result, speculative, j, k);
+	  done = 1;
+	} else {
+	  copyTokens(ctx, result, speculative, j, k - 1);
+	  k --;
+	  if (speculative->types[k] == TK_EOF)
+	    done = 1;
+	  else {
+	    scanner.inputPtr = scanner.inputBuffer + speculative->offsets[k] + speculative->lengths[k];
+	    readChar(&scanner);
+	  }
+	}
+	pending = 0;
+	break;
+      }
+
+      appendStitched(ctx, result, tokenType, offset, length, value);
+      pending = 0;
+      if ((tokenType == TK_EOF) || (tokenType == TK_NONE)) {
+	done = 1;
+	break;
+      }
+    }
+  }
+
+  return result;
+}
+
+TokenBuffer* tokenizeInputParallel(KplContext *ctx, int threadCount) {
+  int size = ctx->inputEnd - ctx->inputBuffer;
+  struct LexChunk *chunks;
+  TokenBuffer *result;
+  int i;
+
+  if (threadCount > size / MIN_CHUNK_SIZE)
+    threadCount = size / MIN_CHUNK_SIZE;
+  if (threadCount <= 1)
+    return tokenizeInput(ctx);
+
+  chunks = (struct LexChunk*) malloc(threadCount * sizeof(struct LexChunk));
+  for (i = 0; i < threadCount; i++) {
+    chunks[i].start = (int) ((long) size * i / threadCount);
+    // The last chunk also owns the TK_EOF token, at offset size
+    chunks[i].end = (i == threadCount - 1) ? size + 1 : (int) ((long) size * (i + 1) / threadCount);
+    forkScanner(ctx, &chunks[i].ctx, chunks[i].start);
+  }
+  for (i = 1; i < threadCount; i++)
+    pthread_create(&chunks[i].thread, NULL, scanChunk, &chunks[i]);
+  scanChunk(&chunks[0]);
+  for (i = 1; i < threadCount; i++)
+    pthread_join(chunks[i].thread, NULL);
+
+  result = stitchChunks(ctx, chunks, threadCount);
+
+  for (i = 0; i < threadCount; i++)
+    freeTokenBuffer(chunks[i].tokens);
+  free(chunks);
+  ctx->tokenIndex = 0;
+  return result;
+}
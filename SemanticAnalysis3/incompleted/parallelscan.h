@@ -0,0 +1,20 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __PARALLELSCAN_H__
+#define __PARALLELSCAN_H__
+
+#include "context.h"
+#include "tokenbuffer.h"
+
+// Chunks smaller than this are not worth a thread
+#ifndef MIN_CHUNK_SIZE
+#define MIN_CHUNK_SIZE (64 * 1024)
+#endif
+
+TokenBuffer* tokenizeInputParallel(KplContext *ctx, int threadCount);
+
+#endif
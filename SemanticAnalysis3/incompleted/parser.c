@@ -5,802 +5,1420 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "reader.h"
 #include "scanner.h"
+#include "tokenbuffer.h"
+#include "parallelscan.h"
+#include "parallelparse.h"
+#include "tokcache.h"
+#include "interner.h"
 #include "parser.h"
 #include "semantics.h"
 #include "error.h"
 #include "debug.h"
+#include "gramsets.h"
+#include "tableparser.h"
 
-Token *currentToken;
-Token *lookAhead;
+void scan(KplContext *ctx)
+{
+  ctx->currentToken = ctx->lookAhead;
+  if (ctx->tokens != NULL)
+    ctx->lookAhead = nextBufferedToken(ctx);
+  else ctx->lookAhead = getValidToken(ctx);
+}
+
+void eat(KplContext *ctx, TokenType tokenType)
+{
+  if (ctx->lookAhead.tokenType == tokenType)
+  {
+    scan(ctx);
+  }
+  else
+    missingToken(ctx, tokenType, ctx->lookAhead.offset);
+}
 
-extern Type *intType;
-extern Type *charType;
-extern SymTab *symtab;
+// Where a statement list goes on after an error: at a separator, at its
+// END, or at the keyword of the next statement when the separator is
+// missing. An identifier can be anywhere in a statement, so it is no sign
+// of the next one.
+#define SYNC_STATEMENTS (TOKEN_BIT(SB_SEMICOLON) | TOKEN_BIT(KW_END) | \
+			 (FIRST_STATEMENT & ~TOKEN_BIT(TK_IDENT)))
 
-void scan(void)
+// Where the declarations of a block go on after an error: past the ; that
+// ends the broken one, or at the next part of the block
+#define SYNC_DECLARATIONS (TOKEN_BIT(SB_SEMICOLON) | TOKEN_BIT(KW_TYPE) | TOKEN_BIT(KW_VAR) | \
+			   FIRST_SUB_DECL | TOKEN_BIT(KW_BEGIN))
+
+// Panic mode: drops the tokens up to one of sync or the end of the input
+void skipTo(KplContext *ctx, TokenSet sync)
 {
-  Token *tmp = currentToken;
-  currentToken = lookAhead;
-  lookAhead = getValidToken();
-  free(tmp);
+  sync |= TOKEN_BIT(TK_EOF);
+  while (!IN_SET(sync, ctx->lookAhead.tokenType))
+    scan(ctx);
 }
 
-void eat(TokenType tokenType)
+// Compiles a statement of a list under a recovery point. When it fails,
+// the error is kept, the rest of the statement is skipped and *resumed
+// tells whether the list goes on with the next one without a separator.
+NodeId compileGuardedStatement(KplContext *ctx, int *resumed)
 {
-  if (lookAhead->tokenType == tokenType)
+  jmp_buf recovery, *outer = ctx->recoveryJump;
+  NodeId statement;
+
+  ctx->recoveryJump = &recovery;
+  if (setjmp(recovery) == 0)
   {
-    scan();
+    statement = compileStatement(ctx);
+    *resumed = 0;
   }
   else
-    missingToken(tokenType, lookAhead->lineNo, lookAhead->colNo);
+  {
+    skipTo(ctx, SYNC_STATEMENTS);
+    statement = NO_NODE;
+    *resumed = IN_SET(FIRST_STATEMENT, ctx->lookAhead.tokenType);
+  }
+  ctx->recoveryJump = outer;
+  return statement;
 }
 
-void compileProgram(void)
+// Compiles a declaration under a recovery point. When it fails, the error
+// is kept, the scope of a broken subprogram is left and the tokens are
+// skipped past the end of the declaration or up to the next part of the
+// block.
+void compileGuardedDeclaration(KplContext *ctx, void (*compileDeclaration)(KplContext *ctx))
 {
-  Object *program;
+  jmp_buf recovery, *outer = ctx->recoveryJump;
+  Scope *scope = ctx->syntaxOnly ? NULL : ctx->symtab->currentScope;
 
-  eat(KW_PROGRAM);
-  eat(TK_IDENT);
+  ctx->recoveryJump = &recovery;
+  if (setjmp(recovery) == 0)
+    compileDeclaration(ctx);
+  else
+  {
+    if (!ctx->syntaxOnly)
+      ctx->symtab->currentScope = scope;
+    skipTo(ctx, SYNC_DECLARATIONS);
+    if (ctx->lookAhead.tokenType == SB_SEMICOLON)
+      scan(ctx);
+  }
+  ctx->recoveryJump = outer;
+}
 
-  program = createProgramObject(currentToken->string);
-  enterBlock(program->progAttrs->scope);
+// Finds the END of the block that starts at the lookahead, by balancing
+// BEGIN and END: every FUNCTION or PROCEDURE opens a block, which the END
+// of its statement part closes. Returns -1 when the stream ends first or
+// holds a lexical error. Only for pretokenized input.
+int skimBlock(KplContext *ctx)
+{
+  TokenBuffer *tokens = ctx->tokens;
+  int blocks = 1, depth = 0, i;
 
-  eat(SB_SEMICOLON);
+  for (i = ctx->tokenIndex - 1; i < tokens->count; i++)
+    switch (tokens->types[i])
+    {
+    case KW_FUNCTION:
+    case KW_PROCEDURE:
+      blocks ++;
+      break;
+    case KW_BEGIN:
+      depth ++;
+      break;
+    case KW_END:
+      if (--depth < 0)
+        return -1;
+      if ((depth == 0) && (--blocks == 0))
+        return i;
+      break;
+    case TK_NONE:
+    case TK_EOF:
+      return -1;
+    default:
+      break;
+    }
+  return -1;
+}
+
+// Goes on from the token at index, as if it had just been eaten
+void skipToToken(KplContext *ctx, int index)
+{
+  ctx->tokenIndex = index;
+  scan(ctx);
+  scan(ctx);
+}
 
-  compileBlock();
-  eat(SB_PERIOD);
+// Finds the END of the statement part that starts at the token at first,
+// by balancing BEGIN and END. Returns -1 when that token is no BEGIN, or
+// when the stream ends first or holds a lexical error.
+int skimStatements(TokenBuffer *tokens, int first)
+{
+  int depth = 0, i;
 
-  exitBlock();
+  if (tokens->types[first] != KW_BEGIN)
+    return -1;
+  for (i = first; i < tokens->count; i++)
+    switch (tokens->types[i])
+    {
+    case KW_BEGIN:
+      depth ++;
+      break;
+    case KW_END:
+      if (--depth == 0)
+        return i;
+      break;
+    case TK_NONE:
+    case TK_EOF:
+      return -1;
+    default:
+      break;
+    }
+  return -1;
 }
 
-void compileBlock(void)
+// In place of the block of a subprogram, whose header has just been
+// compiled: skips it when its body is parsed later, in parallel. Returns
+// 0 when it is to be compiled now.
+int deferBlock(KplContext *ctx, Object *owner)
 {
-  Object *constObj;
-  ConstantValue *constValue;
+  if (ctx->bodyQueue == NULL)
+    return 0;
+  return deferBody(ctx, owner, (owner->kind == OBJ_FUNCTION) ? &owner->funcAttrs->body : &owner->procAttrs->body);
+}
 
-  if (lookAhead->tokenType == KW_CONST)
+// In lazy mode, in place of the statement part of a subprogram, whose
+// declarations have just been compiled: skips it, for subprogramBody() to
+// parse when it is asked for. Returns 0 when it is to be compiled now.
+int deferStatements(KplContext *ctx)
+{
+  Object *owner;
+  int last;
+
+  if (!ctx->lazyBodies || ctx->syntaxOnly || (ctx->tokens == NULL))
+    return 0;
+  owner = ctx->symtab->currentScope->owner;
+  if ((owner->kind != OBJ_FUNCTION) && (owner->kind != OBJ_PROCEDURE))
+    return 0;
+  // The block of a subprogram ends with END ;
+  if (((last = skimStatements(ctx->tokens, ctx->tokenIndex - 1)) < 0) || (ctx->tokens->types[last + 1] != SB_SEMICOLON))
+    return 0;
+
+  if (owner->kind == OBJ_FUNCTION)
   {
-    eat(KW_CONST);
+    owner->funcAttrs->pending = 1;
+    owner->funcAttrs->bodyToken = ctx->tokenIndex - 1;
+  }
+  else
+  {
+    owner->procAttrs->pending = 1;
+    owner->procAttrs->bodyToken = ctx->tokenIndex - 1;
+  }
+  skipToToken(ctx, last);
+  return 1;
+}
 
-    do
+// The block of a subprogram whose header has just been compiled, now or
+// later. With pretokenized input, where its tokens are is kept.
+void compileSubprogramBlock(KplContext *ctx, Object *owner)
+{
+  int first = ctx->tokenIndex - 1;
+  NodeId body = NO_NODE;
+  int deferred = deferBlock(ctx, owner);
+
+  if (!deferred)
+    body = compileBlock(ctx);
+  if (owner->kind == OBJ_FUNCTION)
+  {
+    if (!deferred)
+    {
+      owner->funcAttrs->body = body;
+      owner->funcAttrs->bodyOffset = ctx->ast->base;
+    }
+    if (ctx->tokens != NULL)
+    {
+      owner->funcAttrs->firstToken = first;
+      owner->funcAttrs->lastToken = ctx->tokenIndex - 2;
+    }
+  }
+  else
+  {
+    if (!deferred)
+    {
+      owner->procAttrs->body = body;
+      owner->procAttrs->bodyOffset = ctx->ast->base;
+    }
+    if (ctx->tokens != NULL)
     {
-      eat(TK_IDENT);
-      checkFreshIdent(currentToken->string);
-      // Create a constant object
-      constObj = createConstantObject(currentToken->string);
+      owner->procAttrs->firstToken = first;
+      owner->procAttrs->lastToken = ctx->tokenIndex - 2;
+    }
+  }
+}
+
+// A leaf for the current token, a number or a character
+NodeId tokenNode(KplContext *ctx, enum NodeKind kind)
+{
+  return newNode(ctx->ast, kind, ctx->currentToken.offset, ctx->currentToken.value, 0);
+}
 
-      eat(SB_EQ);
-      // Get the constant value
-      constValue = compileConstant();
-      constObj->constAttrs->value = constValue;
-      // Declare the constant object
-      declareObject(constObj);
+// A node for obj, named by the current token
+NodeId objectNode(KplContext *ctx, enum NodeKind kind, Object *obj, int arguments)
+{
+  return newNode(ctx->ast, kind, ctx->currentToken.offset, obj->index, arguments);
+}
 
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+// left op right, starting where left starts
+NodeId operatorNode(KplContext *ctx, enum NodeKind kind, TokenType op, NodeId left, NodeId right)
+{
+  NodeId node = newNode(ctx->ast, kind, SOURCE_OFFSET(ctx->ast, left), left, right);
 
-    compileBlock2();
-  }
-  else
-    compileBlock2();
+  NODE(ctx->ast, node)->op = op;
+  return node;
 }
 
-void compileBlock2(void)
+void compileProgram(KplContext *ctx)
 {
-  Object *typeObj;
-  Type *actualType;
+  Object *program;
+
+  eat(ctx, KW_PROGRAM);
+  eat(ctx, TK_IDENT);
 
-  if (lookAhead->tokenType == KW_TYPE)
+  if (ctx->syntaxOnly)
   {
-    eat(KW_TYPE);
+    eat(ctx, SB_SEMICOLON);
+    compileBlock(ctx);
+    eat(ctx, SB_PERIOD);
+    return;
+  }
 
-    do
-    {
-      eat(TK_IDENT);
-      // TODO: Check if a type identifier is fresh in the block
-      checkFreshIdent(currentToken->string);
-      // create a type object
-      typeObj = createTypeObject(currentToken->string);
+  program = createProgramObject(ctx, ctx->currentToken.value);
+  enterBlock(ctx, program->progAttrs->scope);
+
+  eat(ctx, SB_SEMICOLON);
+
+  program->progAttrs->body = compileBlock(ctx);
+  program->progAttrs->bodyOffset = ctx->ast->base;
+  eat(ctx, SB_PERIOD);
 
-      eat(SB_EQ);
-      // Get the actual type
-      actualType = compileType();
-      typeObj->typeAttrs->actualType = actualType;
-      // Declare the type object
-      declareObject(typeObj);
+  exitBlock(ctx);
+}
+
+NodeId compileBlock(KplContext *ctx)
+{
+  if (ctx->lookAhead.tokenType == KW_CONST)
+  {
+    eat(ctx, KW_CONST);
 
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+    do
+      compileGuardedDeclaration(ctx, compileConstDecl);
+    while (ctx->lookAhead.tokenType == TK_IDENT);
 
-    compileBlock3();
+    return compileBlock2(ctx);
   }
   else
-    compileBlock3();
+    return compileBlock2(ctx);
 }
 
-void compileBlock3(void)
+NodeId compileBlock2(KplContext *ctx)
 {
-  Object *varObj;
-  Type *varType;
-
-  if (lookAhead->tokenType == KW_VAR)
+  if (ctx->lookAhead.tokenType == KW_TYPE)
   {
-    eat(KW_VAR);
+    eat(ctx, KW_TYPE);
 
     do
-    {
-      eat(TK_IDENT);
-      // Check if a variable identifier is fresh in the block
-      checkFreshIdent(currentToken->string);
+      compileGuardedDeclaration(ctx, compileTypeDecl);
+    while (ctx->lookAhead.tokenType == TK_IDENT);
 
-      // Create a variable object
-      varObj = createVariableObject(currentToken->string);
+    return compileBlock3(ctx);
+  }
+  else
+    return compileBlock3(ctx);
+}
 
-      eat(SB_COLON);
-      // Get the variable type
-      varType = compileType();
-      varObj->varAttrs->type = varType;
-      // Declare the variable object
-      declareObject(varObj);
+NodeId compileBlock3(KplContext *ctx)
+{
+  if (ctx->lookAhead.tokenType == KW_VAR)
+  {
+    eat(ctx, KW_VAR);
 
-      eat(SB_SEMICOLON);
-    } while (lookAhead->tokenType == TK_IDENT);
+    do
+      compileGuardedDeclaration(ctx, compileVarDecl);
+    while (ctx->lookAhead.tokenType == TK_IDENT);
 
-    compileBlock4();
+    return compileBlock4(ctx);
   }
   else
-    compileBlock4();
+    return compileBlock4(ctx);
+}
+
+NodeId compileBlock4(KplContext *ctx)
+{
+  compileSubDecls(ctx);
+  return compileBlock5(ctx);
+}
+
+// The nodes of the statement part are placed from its BEGIN on. The
+// statement parts nested in the block were built before it.
+NodeId compileBlock5(KplContext *ctx)
+{
+  ctx->ast->base = ctx->lookAhead.offset;
+  if (deferStatements(ctx))
+    return NO_NODE;
+  return compileGroupSt(ctx);
+}
+
+void compileConstDecl(KplContext *ctx)
+{
+  Object *constObj;
+  ConstantValue *constValue;
+
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    eat(ctx, SB_EQ);
+    compileConstant(ctx);
+    eat(ctx, SB_SEMICOLON);
+    return;
+  }
+
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  // Create a constant object
+  constObj = createConstantObject(ctx, ctx->currentToken.value);
+
+  eat(ctx, SB_EQ);
+  // Get the constant value
+  constValue = compileConstant(ctx);
+  constObj->constAttrs->value = constValue;
+  // Declare the constant object
+  declareObject(ctx, constObj);
+
+  eat(ctx, SB_SEMICOLON);
 }
 
-void compileBlock4(void)
+void compileTypeDecl(KplContext *ctx)
 {
-  compileSubDecls();
-  compileBlock5();
+  Object *typeObj;
+  Type *actualType;
+
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    eat(ctx, SB_EQ);
+    compileType(ctx);
+    eat(ctx, SB_SEMICOLON);
+    return;
+  }
+
+  // TODO: Check if a type identifier is fresh in the block
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  // create a type object
+  typeObj = createTypeObject(ctx, ctx->currentToken.value);
+
+  eat(ctx, SB_EQ);
+  // Get the actual type
+  actualType = compileType(ctx);
+  typeObj->typeAttrs->actualType = actualType;
+  // Declare the type object
+  declareObject(ctx, typeObj);
+
+  eat(ctx, SB_SEMICOLON);
 }
 
-void compileBlock5(void)
+void compileVarDecl(KplContext *ctx)
 {
-  eat(KW_BEGIN);
-  compileStatements();
-  eat(KW_END);
+  Object *varObj;
+  Type *varType;
+
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    eat(ctx, SB_COLON);
+    compileType(ctx);
+    eat(ctx, SB_SEMICOLON);
+    return;
+  }
+
+  // Check if a variable identifier is fresh in the block
+  checkFreshIdent(ctx, ctx->currentToken.value);
+
+  // Create a variable object
+  varObj = createVariableObject(ctx, ctx->currentToken.value);
+
+  eat(ctx, SB_COLON);
+  // Get the variable type
+  varType = compileType(ctx);
+  varObj->varAttrs->type = varType;
+  // Declare the variable object
+  declareObject(ctx, varObj);
+
+  eat(ctx, SB_SEMICOLON);
 }
 
-void compileSubDecls(void)
+void compileSubDecls(KplContext *ctx)
 {
-  while ((lookAhead->tokenType == KW_FUNCTION) || (lookAhead->tokenType == KW_PROCEDURE))
+  while ((ctx->lookAhead.tokenType == KW_FUNCTION) || (ctx->lookAhead.tokenType == KW_PROCEDURE))
   {
-    if (lookAhead->tokenType == KW_FUNCTION)
-      compileFuncDecl();
+    if (ctx->lookAhead.tokenType == KW_FUNCTION)
+      compileGuardedDeclaration(ctx, compileFuncDecl);
     else
-      compileProcDecl();
+      compileGuardedDeclaration(ctx, compileProcDecl);
   }
+
+  if ((ctx->bodyQueue != NULL) && (ctx->symtab->currentScope == ctx->symtab->program->progAttrs->scope))
+    parseDeferredBodies(ctx);
 }
 
-void compileFuncDecl(void)
+void compileFuncDecl(KplContext *ctx)
 {
   Object *funcObj;
   Type *returnType;
 
-  eat(KW_FUNCTION);
-  eat(TK_IDENT);
+  eat(ctx, KW_FUNCTION);
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    compileParams(ctx);
+    eat(ctx, SB_COLON);
+    compileBasicType(ctx);
+    eat(ctx, SB_SEMICOLON);
+    compileBlock(ctx);
+    eat(ctx, SB_SEMICOLON);
+    return;
+  }
+
   // Check if a function identifier is fresh in the block
-  checkFreshIdent(currentToken->string);
+  checkFreshIdent(ctx, ctx->currentToken.value);
 
   // create the function object
-  funcObj = createFunctionObject(currentToken->string);
+  funcObj = createFunctionObject(ctx, ctx->currentToken.value);
   // declare the function object
-  declareObject(funcObj);
+  declareObject(ctx, funcObj);
   // enter the function's block
-  enterBlock(funcObj->funcAttrs->scope);
+  enterBlock(ctx, funcObj->funcAttrs->scope);
   // parse the function's parameters
-  compileParams();
-  eat(SB_COLON);
+  compileParams(ctx);
+  eat(ctx, SB_COLON);
   // get the funtion's return type
-  returnType = compileBasicType();
+  returnType = compileBasicType(ctx);
   funcObj->funcAttrs->returnType = returnType;
 
-  eat(SB_SEMICOLON);
-  compileBlock();
-  eat(SB_SEMICOLON);
+  eat(ctx, SB_SEMICOLON);
+  compileSubprogramBlock(ctx, funcObj);
+  eat(ctx, SB_SEMICOLON);
   // exit the function block
-  exitBlock();
+  exitBlock(ctx);
 }
 
-void compileProcDecl(void)
+void compileProcDecl(KplContext *ctx)
 {
   Object *procObj;
 
-  eat(KW_PROCEDURE);
-  eat(TK_IDENT);
+  eat(ctx, KW_PROCEDURE);
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    compileParams(ctx);
+    eat(ctx, SB_SEMICOLON);
+    compileBlock(ctx);
+    eat(ctx, SB_SEMICOLON);
+    return;
+  }
+
   // Check if a procedure identifier is fresh in the block
-  checkFreshIdent(currentToken->string);
+  checkFreshIdent(ctx, ctx->currentToken.value);
   // create a procedure object
-  procObj = createProcedureObject(currentToken->string);
+  procObj = createProcedureObject(ctx, ctx->currentToken.value);
   // declare the procedure object
-  declareObject(procObj);
+  declareObject(ctx, procObj);
   // enter the procedure's block
-  enterBlock(procObj->procAttrs->scope);
+  enterBlock(ctx, procObj->procAttrs->scope);
   // parse the procedure's parameters
-  compileParams();
+  compileParams(ctx);
 
-  eat(SB_SEMICOLON);
-  compileBlock();
-  eat(SB_SEMICOLON);
+  eat(ctx, SB_SEMICOLON);
+  compileSubprogramBlock(ctx, procObj);
+  eat(ctx, SB_SEMICOLON);
   // exit the block
-  exitBlock();
+  exitBlock(ctx);
 }
 
-ConstantValue *compileUnsignedConstant(void)
+ConstantValue *compileUnsignedConstant(KplContext *ctx)
 {
   ConstantValue *constValue;
   Object *obj;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case TK_NUMBER:
-    eat(TK_NUMBER);
-    constValue = makeIntConstant(currentToken->value);
+    eat(ctx, TK_NUMBER);
+    constValue = makeIntConstant(ctx->currentToken.value);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
+    eat(ctx, TK_IDENT);
     // check if the constant identifier is declared and get its value
-    obj = checkDeclaredConstant(currentToken->string);
+    obj = checkDeclaredConstant(ctx, ctx->currentToken.value);
     if (obj != NULL)
       constValue = duplicateConstantValue(obj->constAttrs->value);
     else
-      error(ERR_UNDECLARED_CONSTANT, currentToken->lineNo, currentToken->colNo);
+      error(ctx, ERR_UNDECLARED_CONSTANT, ctx->currentToken.offset);
     break;
   case TK_CHAR:
-    eat(TK_CHAR);
-    constValue = makeCharConstant(currentToken->string[0]);
+    eat(ctx, TK_CHAR);
+    constValue = makeCharConstant(ctx->currentToken.value);
     break;
   default:
-    error(ERR_INVALID_CONSTANT, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_CONSTANT, ctx->lookAhead.offset);
     break;
   }
   return constValue;
 }
 
-ConstantValue *compileConstant(void)
+ConstantValue *compileConstant(KplContext *ctx)
 {
   ConstantValue *constValue;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case SB_PLUS:
-    eat(SB_PLUS);
-    constValue = compileConstant2();
+    eat(ctx, SB_PLUS);
+    constValue = compileConstant2(ctx);
     break;
   case SB_MINUS:
-    eat(SB_MINUS);
-    constValue = compileConstant2();
-    constValue->intValue = -constValue->intValue;
+    eat(ctx, SB_MINUS);
+    constValue = compileConstant2(ctx);
+    if (constValue != NULL)
+      constValue->intValue = -constValue->intValue;
     break;
   case TK_CHAR:
-    eat(TK_CHAR);
-    constValue = makeCharConstant(currentToken->string[0]);
+    eat(ctx, TK_CHAR);
+    if (ctx->syntaxOnly)
+      return NULL;
+    constValue = makeCharConstant(ctx->currentToken.value);
     break;
   default:
-    constValue = compileConstant2();
+    constValue = compileConstant2(ctx);
     break;
   }
   return constValue;
 }
 
-ConstantValue *compileConstant2(void)
+ConstantValue *compileConstant2(KplContext *ctx)
 {
   ConstantValue *constValue;
   Object *obj;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case TK_NUMBER:
-    eat(TK_NUMBER);
-    constValue = makeIntConstant(currentToken->value);
+    eat(ctx, TK_NUMBER);
+    if (ctx->syntaxOnly)
+      return NULL;
+    constValue = makeIntConstant(ctx->currentToken.value);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
+    eat(ctx, TK_IDENT);
+    if (ctx->syntaxOnly)
+      return NULL;
     // check if the integer constant identifier is declared and get its value
-    obj = checkDeclaredConstant(currentToken->string);
+    obj = checkDeclaredConstant(ctx, ctx->currentToken.value);
     if (obj != NULL)
       constValue = duplicateConstantValue(obj->constAttrs->value);
     else
-      error(ERR_UNDECLARED_CONSTANT, currentToken->lineNo, currentToken->colNo);
+      error(ctx, ERR_UNDECLARED_CONSTANT, ctx->currentToken.offset);
     break;
   default:
-    error(ERR_INVALID_CONSTANT, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_CONSTANT, ctx->lookAhead.offset);
     break;
   }
   return constValue;
 }
 
-Type *compileType(void)
+Type *compileType(KplContext *ctx)
 {
   Type *type;
   Type *elementType;
   int arraySize;
   Object *obj;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case KW_INTEGER:
-    eat(KW_INTEGER);
+    eat(ctx, KW_INTEGER);
+    if (ctx->syntaxOnly)
+      return NULL;
     type = makeIntType();
     break;
   case KW_CHAR:
-    eat(KW_CHAR);
+    eat(ctx, KW_CHAR);
+    if (ctx->syntaxOnly)
+      return NULL;
     type = makeCharType();
     break;
   case KW_ARRAY:
-    eat(KW_ARRAY);
-    eat(SB_LSEL);
-    eat(TK_NUMBER);
+    eat(ctx, KW_ARRAY);
+    eat(ctx, SB_LSEL);
+    eat(ctx, TK_NUMBER);
 
-    arraySize = currentToken->value;
+    arraySize = ctx->currentToken.value;
 
-    eat(SB_RSEL);
-    eat(KW_OF);
-    elementType = compileType();
+    eat(ctx, SB_RSEL);
+    eat(ctx, KW_OF);
+    elementType = compileType(ctx);
+    if (ctx->syntaxOnly)
+      return NULL;
     type = makeArrayType(arraySize, elementType);
     break;
   case TK_IDENT:
-    eat(TK_IDENT);
+    eat(ctx, TK_IDENT);
+    if (ctx->syntaxOnly)
+      return NULL;
     // check if the type idntifier is declared and get its actual type
-    obj = checkDeclaredType(currentToken->string);
+    obj = checkDeclaredType(ctx, ctx->currentToken.value);
     if (obj != NULL)
       type = duplicateType(obj->typeAttrs->actualType);
     else
-      error(ERR_UNDECLARED_TYPE, currentToken->lineNo, currentToken->colNo);
+      error(ctx, ERR_UNDECLARED_TYPE, ctx->currentToken.offset);
     break;
   default:
-    error(ERR_INVALID_TYPE, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_TYPE, ctx->lookAhead.offset);
     break;
   }
   return type;
 }
 
-Type *compileBasicType(void)
+Type *compileBasicType(KplContext *ctx)
 {
   Type *type;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case KW_INTEGER:
-    eat(KW_INTEGER);
+    eat(ctx, KW_INTEGER);
+    if (ctx->syntaxOnly)
+      return NULL;
     type = makeIntType();
     break;
   case KW_CHAR:
-    eat(KW_CHAR);
+    eat(ctx, KW_CHAR);
+    if (ctx->syntaxOnly)
+      return NULL;
     type = makeCharType();
     break;
   default:
-    error(ERR_INVALID_BASICTYPE, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_BASICTYPE, ctx->lookAhead.offset);
     break;
   }
   return type;
 }
 
-void compileParams(void)
+void compileParams(KplContext *ctx)
 {
-  if (lookAhead->tokenType == SB_LPAR)
+  if (ctx->lookAhead.tokenType == SB_LPAR)
   {
-    eat(SB_LPAR);
-    compileParam();
-    while (lookAhead->tokenType == SB_SEMICOLON)
+    eat(ctx, SB_LPAR);
+    compileParam(ctx);
+    while (ctx->lookAhead.tokenType == SB_SEMICOLON)
     {
-      eat(SB_SEMICOLON);
-      compileParam();
+      eat(ctx, SB_SEMICOLON);
+      compileParam(ctx);
     }
-    eat(SB_RPAR);
+    eat(ctx, SB_RPAR);
   }
 }
 
-void compileParam(void)
+void compileParam(KplContext *ctx)
 {
   Object *param;
   Type *type;
   enum ParamKind paramKind;
 
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case TK_IDENT:
     paramKind = PARAM_VALUE;
     break;
   case KW_VAR:
-    eat(KW_VAR);
+    eat(ctx, KW_VAR);
     paramKind = PARAM_REFERENCE;
     break;
   default:
-    error(ERR_INVALID_PARAMETER, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_PARAMETER, ctx->lookAhead.offset);
     break;
   }
 
-  eat(TK_IDENT);
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+  {
+    eat(ctx, SB_COLON);
+    compileBasicType(ctx);
+    return;
+  }
+
   // check if the parameter identifier is fresh in the block
-  checkFreshIdent(currentToken->string);
-  param = createParameterObject(currentToken->string, paramKind, symtab->currentScope->owner);
-  eat(SB_COLON);
-  type = compileBasicType();
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  param = createParameterObject(ctx, ctx->currentToken.value, paramKind, ctx->symtab->currentScope->owner);
+  eat(ctx, SB_COLON);
+  type = compileBasicType(ctx);
   param->paramAttrs->type = type;
-  declareObject(param);
+  declareObject(ctx, param);
 }
 
-void compileStatements(void)
+// The statements are chained in a list; empty ones and broken ones are
+// left out
+int compileStatements(KplContext *ctx)
 {
-  compileStatement();
-  while (lookAhead->tokenType == SB_SEMICOLON)
+  int list = NO_LIST, last = NO_LIST, resumed;
+
+  appendNode(ctx->ast, &list, &last, compileGuardedStatement(ctx, &resumed));
+  for (;;)
   {
-    eat(SB_SEMICOLON);
-    compileStatement();
+    if (ctx->lookAhead.tokenType == SB_SEMICOLON)
+      eat(ctx, SB_SEMICOLON);
+    else if (!resumed)
+    {
+      // A statement right after another one lacks the separator. It is
+      // reported where END was expected, and the list goes on.
+      if (!IN_SET(FIRST_STATEMENT, ctx->lookAhead.tokenType))
+        break;
+      insertedToken(ctx, KW_END, ctx->lookAhead.offset);
+    }
+    appendNode(ctx->ast, &list, &last, compileGuardedStatement(ctx, &resumed));
   }
+  return list;
 }
 
-void compileStatement(void)
+NodeId compileStatement(KplContext *ctx)
 {
-  switch (lookAhead->tokenType)
+  switch (ctx->lookAhead.tokenType)
   {
   case TK_IDENT:
-    compileAssignSt();
-    break;
+    return compileAssignSt(ctx);
   case KW_CALL:
-    compileCallSt();
-    break;
+    return compileCallSt(ctx);
   case KW_BEGIN:
-    compileGroupSt();
-    break;
+    return compileGroupSt(ctx);
   case KW_IF:
-    compileIfSt();
-    break;
+    return compileIfSt(ctx);
   case KW_WHILE:
-    compileWhileSt();
-    break;
+    return compileWhileSt(ctx);
   case KW_FOR:
-    compileForSt();
-    break;
-    // EmptySt needs to check FOLLOW tokens
-  case SB_SEMICOLON:
-  case KW_END:
-  case KW_ELSE:
-    break;
-    // Error occurs
+    return compileForSt(ctx);
   default:
-    error(ERR_INVALID_STATEMENT, lookAhead->lineNo, lookAhead->colNo);
-    break;
+    // EmptySt needs to check FOLLOW tokens
+    if (!IN_SET(FOLLOW_STATEMENT, ctx->lookAhead.tokenType))
+      error(ctx, ERR_INVALID_STATEMENT, ctx->lookAhead.offset);
+    return NO_NODE;
   }
 }
 
-void compileLValue(void)
+NodeId compileLValue(KplContext *ctx)
 {
   Object *var;
 
-  eat(TK_IDENT);
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+    return compileIndexes(ctx, NO_NODE);
+
   // check if the identifier is a function identifier, or a variable identifier, or a parameter
-  var = checkDeclaredLValueIdent(currentToken->string);
-  if (var->kind == OBJ_VARIABLE)
-    compileIndexes();
+  var = checkDeclaredLValueIdent(ctx, ctx->currentToken.value);
+  switch (var->kind)
+  {
+  case OBJ_VARIABLE:
+    return compileIndexes(ctx, objectNode(ctx, N_VARIABLE, var, 0));
+  case OBJ_PARAMETER:
+    return objectNode(ctx, N_PARAMETER, var, 0);
+  default:
+    return objectNode(ctx, N_FUNCTION, var, NO_LIST);
+  }
 }
 
-void compileAssignSt(void)
+NodeId compileAssignSt(KplContext *ctx)
 {
-  compileLValue();
-  eat(SB_ASSIGN);
-  compileExpression();
+  int offset = ctx->lookAhead.offset;
+  NodeId lvalue, expression;
+
+  lvalue = compileLValue(ctx);
+  eat(ctx, SB_ASSIGN);
+  expression = compileExpression(ctx);
+  return newNode(ctx->ast, N_ASSIGN, offset, lvalue, expression);
 }
 
-void compileCallSt(void)
+NodeId compileCallSt(KplContext *ctx)
 {
-  eat(KW_CALL);
-  eat(TK_IDENT);
+  int offset = ctx->lookAhead.offset;
+
+  eat(ctx, KW_CALL);
+  eat(ctx, TK_IDENT);
+  if (ctx->syntaxOnly)
+    return newNode(ctx->ast, N_CALL, offset, 0, compileArguments(ctx));
+
   // check if the identifier is a declared procedure
-  Object *proc = checkDeclaredProcedure(currentToken->string);
-  if (proc != NULL)
-    compileArguments();
-  else
-    error(ERR_UNDECLARED_PROCEDURE, currentToken->lineNo, currentToken->colNo);
+  Object *proc = checkDeclaredProcedure(ctx, ctx->currentToken.value);
+  if (proc == NULL)
+    error(ctx, ERR_UNDECLARED_PROCEDURE, ctx->currentToken.offset);
+  return newNode(ctx->ast, N_CALL, offset, proc->index, compileArguments(ctx));
 }
 
-void compileGroupSt(void)
+NodeId compileGroupSt(KplContext *ctx)
 {
-  eat(KW_BEGIN);
-  compileStatements();
-  eat(KW_END);
+  int offset = ctx->lookAhead.offset;
+  int statements;
+
+  eat(ctx, KW_BEGIN);
+  statements = compileStatements(ctx);
+  eat(ctx, KW_END);
+  return newNode(ctx->ast, N_GROUP, offset, statements, 0);
 }
 
-void compileIfSt(void)
+NodeId compileIfSt(KplContext *ctx)
 {
-  eat(KW_IF);
-  compileCondition();
-  eat(KW_THEN);
-  compileStatement();
-  if (lookAhead->tokenType == KW_ELSE)
-    compileElseSt();
+  int offset = ctx->lookAhead.offset;
+  int branches = newExtra(ctx->ast, 2);
+  NodeId condition, thenPart, elsePart = NO_NODE;
+
+  eat(ctx, KW_IF);
+  condition = compileCondition(ctx);
+  eat(ctx, KW_THEN);
+  thenPart = compileStatement(ctx);
+  if (ctx->lookAhead.tokenType == KW_ELSE)
+    elsePart = compileElseSt(ctx);
+
+  ctx->ast->extra[branches] = thenPart;
+  ctx->ast->extra[branches + 1] = elsePart;
+  return newNode(ctx->ast, N_IF, offset, condition, branches);
 }
 
-void compileElseSt(void)
+NodeId compileElseSt(KplContext *ctx)
 {
-  eat(KW_ELSE);
-  compileStatement();
+  eat(ctx, KW_ELSE);
+  return compileStatement(ctx);
 }
 
-void compileWhileSt(void)
+NodeId compileWhileSt(KplContext *ctx)
 {
-  eat(KW_WHILE);
-  compileCondition();
-  eat(KW_DO);
-  compileStatement();
+  int offset = ctx->lookAhead.offset;
+  NodeId condition, body;
+
+  eat(ctx, KW_WHILE);
+  condition = compileCondition(ctx);
+  eat(ctx, KW_DO);
+  body = compileStatement(ctx);
+  return newNode(ctx->ast, N_WHILE, offset, condition, body);
 }
 
-void compileForSt(void)
+NodeId compileForSt(KplContext *ctx)
 {
-  eat(KW_FOR);
-  eat(TK_IDENT);
+  int offset = ctx->lookAhead.offset;
+  int parts = newExtra(ctx->ast, 3);
+  NodeId from, to, body;
+
+  eat(ctx, KW_FOR);
+  eat(ctx, TK_IDENT);
 
   // check if the identifier is a variable
-  Object *var = checkDeclaredVariable(currentToken->string);
-  if (var == NULL)
-    error(ERR_UNDECLARED_VARIABLE, currentToken->lineNo, currentToken->colNo);
+  Object *var = NULL;
+  if (!ctx->syntaxOnly)
+  {
+    var = checkDeclaredVariable(ctx, ctx->currentToken.value);
+    if (var == NULL)
+      error(ctx, ERR_UNDECLARED_VARIABLE, ctx->currentToken.offset);
+  }
+
+  eat(ctx, SB_ASSIGN);
+  from = compileExpression(ctx);
 
-  eat(SB_ASSIGN);
-  compileExpression();
+  eat(ctx, KW_TO);
+  to = compileExpression(ctx);
 
-  eat(KW_TO);
-  compileExpression();
+  eat(ctx, KW_DO);
+  body = compileStatement(ctx);
 
-  eat(KW_DO);
-  compileStatement();
+  ctx->ast->extra[parts] = from;
+  ctx->ast->extra[parts + 1] = to;
+  ctx->ast->extra[parts + 2] = body;
+  return newNode(ctx->ast, N_FOR, offset, (var != NULL) ? var->index : 0, parts);
 }
 
-void compileArgument(void)
+NodeId compileArgument(KplContext *ctx)
 {
-  compileExpression();
+  return compileExpression(ctx);
 }
 
-void compileArguments(void)
+// The arguments are chained in a list, NO_LIST when there are none
+int compileArguments(KplContext *ctx)
 {
-  switch (lookAhead->tokenType)
+  int list = NO_LIST, last = NO_LIST;
+
+  switch (ctx->lookAhead.tokenType)
   {
   case SB_LPAR:
-    eat(SB_LPAR);
-    compileArgument();
+    eat(ctx, SB_LPAR);
+    appendNode(ctx->ast, &list, &last, compileArgument(ctx));
 
-    while (lookAhead->tokenType == SB_COMMA)
+    while (ctx->lookAhead.tokenType == SB_COMMA)
     {
-      eat(SB_COMMA);
-      compileArgument();
+      eat(ctx, SB_COMMA);
+      appendNode(ctx->ast, &list, &last, compileArgument(ctx));
     }
 
-    eat(SB_RPAR);
-    break;
-    // Check FOLLOW set
-  case SB_TIMES:
-  case SB_SLASH:
-  case SB_PLUS:
-  case SB_MINUS:
-  case KW_TO:
-  case KW_DO:
-  case SB_RPAR:
-  case SB_COMMA:
-  case SB_EQ:
-  case SB_NEQ:
-  case SB_LE:
-  case SB_LT:
-  case SB_GE:
-  case SB_GT:
-  case SB_RSEL:
-  case SB_SEMICOLON:
-  case KW_END:
-  case KW_ELSE:
-  case KW_THEN:
+    eat(ctx, SB_RPAR);
     break;
   default:
-    error(ERR_INVALID_ARGUMENTS, lookAhead->lineNo, lookAhead->colNo);
+    // Check FOLLOW set
+    if (!IN_SET(FOLLOW_ARGUMENTS, ctx->lookAhead.tokenType))
+      error(ctx, ERR_INVALID_ARGUMENTS, ctx->lookAhead.offset);
   }
+  return list;
 }
 
-void compileCondition(void)
+NodeId compileCondition(KplContext *ctx)
 {
-  compileExpression();
+  NodeId left, right;
+  TokenType op;
 
-  switch (lookAhead->tokenType)
+  left = compileExpression(ctx);
+
+  switch (ctx->lookAhead.tokenType)
   {
   case SB_EQ:
-    eat(SB_EQ);
+    eat(ctx, SB_EQ);
     break;
   case SB_NEQ:
-    eat(SB_NEQ);
+    eat(ctx, SB_NEQ);
     break;
   case SB_LE:
-    eat(SB_LE);
+    eat(ctx, SB_LE);
     break;
   case SB_LT:
-    eat(SB_LT);
+    eat(ctx, SB_LT);
     break;
   case SB_GE:
-    eat(SB_GE);
+    eat(ctx, SB_GE);
     break;
   case SB_GT:
-    eat(SB_GT);
+    eat(ctx, SB_GT);
     break;
   default:
-    error(ERR_INVALID_COMPARATOR, lookAhead->lineNo, lookAhead->colNo);
+    error(ctx, ERR_INVALID_COMPARATOR, ctx->lookAhead.offset);
   }
+  op = ctx->currentToken.tokenType;
 
-  compileExpression();
+  right = compileExpression(ctx);
+  return operatorNode(ctx, N_CONDITION, op, left, right);
 }
 
-void compileExpression(void)
+// How tight the binary operators bind, 0 for the other tokens
+#define PREC_ADDITIVE 1
+#define PREC_MULTIPLICATIVE 2
+#define MAX_PRECEDENCE 2
+
+int precedence[SB_RSEL + 1] = {
+  [SB_PLUS] = PREC_ADDITIVE,
+  [SB_MINUS] = PREC_ADDITIVE,
+  [SB_TIMES] = PREC_MULTIPLICATIVE,
+  [SB_SLASH] = PREC_MULTIPLICATIVE
+};
+
+// An operator waiting for its right operand. A leading minus has no
+// left operand.
+struct PendingOperator {
+  NodeId left;
+  TokenType op;
+  int offset;
+};
+
+// Expression ::= [+|-] Term {(+|-) Term} and Term ::= Factor {(*|/) Factor},
+// parsed by precedence climbing in one loop instead of a call per
+// operator. An operator is reduced as soon as one that binds no tighter
+// follows it, so the operators are left associative and the stack never
+// holds more than one per level. The leading minus waits on the stack at
+// the level of + and so negates the first term.
+NodeId compileExpression(KplContext *ctx)
 {
-  switch (lookAhead->tokenType)
+  struct PendingOperator stack[MAX_PRECEDENCE];
+  int depth = 0, level;
+  NodeId operand;
+  TokenType op;
+
+  switch (ctx->lookAhead.tokenType)
   {
   case SB_PLUS:
-    eat(SB_PLUS);
-    compileExpression2();
+    eat(ctx, SB_PLUS);
     break;
   case SB_MINUS:
-    eat(SB_MINUS);
-    compileExpression2();
+    stack[0].left = NO_NODE;
+    stack[0].op = SB_MINUS;
+    stack[0].offset = ctx->lookAhead.offset;
+    depth = 1;
+    eat(ctx, SB_MINUS);
     break;
   default:
-    compileExpression2();
+    break;
+  }
+
+  for (;;)
+  {
+    operand = compileFactor(ctx);
+    op = ctx->lookAhead.tokenType;
+    level = precedence[op];
+
+    // The end of the expression: check the FOLLOW set of Term, which
+    // holds that of Expression
+    if ((level == 0) && !IN_SET(FOLLOW_TERM, op))
+      error(ctx, ERR_INVALID_TERM, ctx->lookAhead.offset);
+
+    while ((depth > 0) && (precedence[stack[depth - 1].op] >= level))
+    {
+      depth --;
+      if (stack[depth].left == NO_NODE)
+        operand = newNode(ctx->ast, N_NEGATE, stack[depth].offset, operand, 0);
+      else operand = operatorNode(ctx, N_BINARY, stack[depth].op, stack[depth].left, operand);
+    }
+    if (level == 0)
+      return operand;
+
+    stack[depth].left = operand;
+    stack[depth].op = op;
+    depth ++;
+    eat(ctx, op);
   }
 }
 
-void compileExpression2(void)
+NodeId compileFactor(KplContext *ctx)
 {
-  compileTerm();
-  compileExpression3();
+  Object *obj;
+  int offset;
+
+  switch (ctx->lookAhead.tokenType)
+  {
+  case TK_NUMBER:
+    eat(ctx, TK_NUMBER);
+    return tokenNode(ctx, N_NUMBER);
+  case TK_CHAR:
+    eat(ctx, TK_CHAR);
+    return tokenNode(ctx, N_CHAR);
+  case TK_IDENT:
+    eat(ctx, TK_IDENT);
+    // Without the symbol table, the grammar allows indexes or arguments
+    // after any identifier
+    if (ctx->syntaxOnly)
+    {
+      if (ctx->lookAhead.tokenType == SB_LPAR)
+        return newNode(ctx->ast, N_FUNCTION, ctx->currentToken.offset, 0, compileArguments(ctx));
+      return compileIndexes(ctx, NO_NODE);
+    }
+
+    // check if the identifier is declared
+    obj = checkDeclaredIdent(ctx, ctx->currentToken.value);
+
+    switch (obj->kind)
+    {
+    case OBJ_CONSTANT:
+      return objectNode(ctx, N_CONSTANT, obj, 0);
+    case OBJ_VARIABLE:
+      return compileIndexes(ctx, objectNode(ctx, N_VARIABLE, obj, 0));
+    case OBJ_PARAMETER:
+      return objectNode(ctx, N_PARAMETER, obj, 0);
+    case OBJ_FUNCTION:
+      offset = ctx->currentToken.offset;
+      return newNode(ctx->ast, N_FUNCTION, offset, obj->index, compileArguments(ctx));
+    default:
+      error(ctx, ERR_INVALID_FACTOR, ctx->currentToken.offset);
+      return NO_NODE;
+    }
+  default:
+    error(ctx, ERR_INVALID_FACTOR, ctx->lookAhead.offset);
+    return NO_NODE;
+  }
 }
 
-void compileExpression3(void)
+// Wraps base in an N_INDEX node for each subscript
+NodeId compileIndexes(KplContext *ctx, NodeId base)
 {
-  switch (lookAhead->tokenType)
+  NodeId index;
+
+  while (ctx->lookAhead.tokenType == SB_LSEL)
   {
-  case SB_PLUS:
-    eat(SB_PLUS);
-    compileTerm();
-    compileExpression3();
-    break;
-  case SB_MINUS:
-    eat(SB_MINUS);
-    compileTerm();
-    compileExpression3();
-    break;
-    // check the FOLLOW set
-  case KW_TO:
-  case KW_DO:
-  case SB_RPAR:
-  case SB_COMMA:
-  case SB_EQ:
-  case SB_NEQ:
-  case SB_LE:
-  case SB_LT:
-  case SB_GE:
-  case SB_GT:
-  case SB_RSEL:
-  case SB_SEMICOLON:
-  case KW_END:
-  case KW_ELSE:
-  case KW_THEN:
-    break;
-  default:
-    error(ERR_INVALID_EXPRESSION, lookAhead->lineNo, lookAhead->colNo);
+    eat(ctx, SB_LSEL);
+    index = compileExpression(ctx);
+    eat(ctx, SB_RSEL);
+    base = newNode(ctx->ast, N_INDEX, SOURCE_OFFSET(ctx->ast, base), base, index);
   }
+  return base;
 }
 
-void compileTerm(void)
+// Returns the body of a subprogram, parsed first if its statement part
+// was left for later. It is parsed as it would have been in place, in the
+// scope its declarations filled. Its errors are added to the diagnostics,
+// but the recovery ends with it. Nothing more is parsed once maxErrors
+// have been reported.
+NodeId subprogramBody(KplContext *ctx, Object *subprogram)
 {
-  compileFactor();
-  compileTerm2();
+  int tokenIndex = ctx->tokenIndex;
+  Token currentToken = ctx->currentToken, lookAhead = ctx->lookAhead;
+  Scope *currentScope = ctx->symtab->currentScope;
+  jmp_buf *recoveryJump = ctx->recoveryJump;
+  jmp_buf errorJump;
+  int *pending, bodyToken, *bodyOffset, base = ctx->ast->base;
+  NodeId *body;
+  Scope *scope;
+
+  if (subprogram->kind == OBJ_FUNCTION)
+  {
+    pending = &subprogram->funcAttrs->pending;
+    bodyToken = subprogram->funcAttrs->bodyToken;
+    body = &subprogram->funcAttrs->body;
+    bodyOffset = &subprogram->funcAttrs->bodyOffset;
+    scope = subprogram->funcAttrs->scope;
+  }
+  else
+  {
+    pending = &subprogram->procAttrs->pending;
+    bodyToken = subprogram->procAttrs->bodyToken;
+    body = &subprogram->procAttrs->body;
+    bodyOffset = &subprogram->procAttrs->bodyOffset;
+    scope = subprogram->procAttrs->scope;
+  }
+  if (!*pending || (ctx->diagnosticCount >= ctx->maxErrors))
+    return *body;
+
+  memcpy(errorJump, ctx->errorJump, sizeof(jmp_buf));
+  ctx->tokenIndex = bodyToken;
+  *pending = 0;
+  enterBlock(ctx, scope);
+  ctx->recoveryJump = NULL;
+  if (setjmp(ctx->errorJump) == 0)
+  {
+    scan(ctx);
+    ctx->ast->base = ctx->lookAhead.offset;
+    *body = compileGroupSt(ctx);
+    *bodyOffset = ctx->ast->base;
+  }
+
+  memcpy(ctx->errorJump, errorJump, sizeof(jmp_buf));
+  ctx->ast->base = base;
+  ctx->recoveryJump = recoveryJump;
+  ctx->symtab->currentScope = currentScope;
+  ctx->tokenIndex = tokenIndex;
+  ctx->currentToken = currentToken;
+  ctx->lookAhead = lookAhead;
+  return *body;
 }
 
-void compileTerm2(void)
+// Parses every body left for later in obj, a subprogram or the program,
+// the outer ones first
+void compileLazyBodies(KplContext *ctx, Object *obj)
 {
-  switch (lookAhead->tokenType)
+  ObjectNode *list;
+
+  switch (obj->kind)
   {
-  case SB_TIMES:
-    eat(SB_TIMES);
-    compileFactor();
-    compileTerm2();
+  case OBJ_FUNCTION:
+    subprogramBody(ctx, obj);
+    list = obj->funcAttrs->scope->objList;
     break;
-  case SB_SLASH:
-    eat(SB_SLASH);
-    compileFactor();
-    compileTerm2();
+  case OBJ_PROCEDURE:
+    subprogramBody(ctx, obj);
+    list = obj->procAttrs->scope->objList;
     break;
-    // check the FOLLOW set
-  case SB_PLUS:
-  case SB_MINUS:
-  case KW_TO:
-  case KW_DO:
-  case SB_RPAR:
-  case SB_COMMA:
-  case SB_EQ:
-  case SB_NEQ:
-  case SB_LE:
-  case SB_LT:
-  case SB_GE:
-  case SB_GT:
-  case SB_RSEL:
-  case SB_SEMICOLON:
-  case KW_END:
-  case KW_ELSE:
-  case KW_THEN:
+  case OBJ_PROGRAM:
+    list = obj->progAttrs->scope->objList;
     break;
   default:
-    error(ERR_INVALID_TERM, lookAhead->lineNo, lookAhead->colNo);
+    return;
   }
+
+  for (; list != NULL; list = list->next)
+    compileLazyBodies(ctx, list->object);
 }
 
-void compileFactor(void)
+// The number of subprograms in obj, a subprogram or the program, whose
+// statement part is still left for later
+int pendingBodies(Object *obj)
 {
-  Object *obj;
+  ObjectNode *list;
+  int count = 0;
 
-  switch (lookAhead->tokenType)
+  switch (obj->kind)
   {
-  case TK_NUMBER:
-    eat(TK_NUMBER);
+  case OBJ_FUNCTION:
+    count = obj->funcAttrs->pending;
+    list = obj->funcAttrs->scope->objList;
     break;
-  case TK_CHAR:
-    eat(TK_CHAR);
+  case OBJ_PROCEDURE:
+    count = obj->procAttrs->pending;
+    list = obj->procAttrs->scope->objList;
     break;
-  case TK_IDENT:
-    eat(TK_IDENT);
-    // check if the identifier is declared
-    obj = checkDeclaredIdent(currentToken->string);
-
-    switch (obj->kind)
-    {
-    case OBJ_CONSTANT:
-      break;
-    case OBJ_VARIABLE:
-      compileIndexes();
-      break;
-    case OBJ_PARAMETER:
-      break;
-    case OBJ_FUNCTION:
-      compileArguments();
-      break;
-    default:
-      error(ERR_INVALID_FACTOR, currentToken->lineNo, currentToken->colNo);
-      break;
-    }
+  case OBJ_PROGRAM:
+    list = obj->progAttrs->scope->objList;
     break;
   default:
-    error(ERR_INVALID_FACTOR, lookAhead->lineNo, lookAhead->colNo);
+    return 0;
+  }
+
+  for (; list != NULL; list = list->next)
+    count += pendingBodies(list->object);
+  return count;
+}
+
+// Fills ctx->tokens, from the token cache of the file when it is enabled
+// and up to date
+void pretokenize(KplContext *ctx, char *fileName)
+{
+  char *cacheName = NULL;
+
+  if (ctx->tokenCache)
+  {
+    cacheName = (char*) malloc(strlen(fileName) + strlen(TOKEN_CACHE_SUFFIX) + 1);
+    strcpy(cacheName, fileName);
+    strcat(cacheName, TOKEN_CACHE_SUFFIX);
+    ctx->tokens = loadTokenCache(ctx, cacheName);
+  }
+
+  if (ctx->tokens == NULL)
+  {
+    ctx->tokens = tokenizeInputParallel(ctx, ctx->scanThreads);
+    if (cacheName != NULL)
+      saveTokenCache(ctx, ctx->tokens, cacheName);
+  }
+  free(cacheName);
+}
+
+// error() comes back here when it gives up on the program
+void parseProgram(KplContext *ctx)
+{
+  ctx->recoveryJump = NULL;
+  ctx->diagnosticCount = 0;
+  ctx->parseIncomplete = 1;
+  if (setjmp(ctx->errorJump) == 0)
+  {
+    scan(ctx);
+    compileProgram(ctx);
+    ctx->parseIncomplete = 0;
   }
+  ctx->recoveryJump = NULL;
 }
 
-void compileIndexes(void)
+// Throws the tree and the symbol table away and parses the pretokenized
+// program again from the start, sequentially, with every body in place
+void parseProgramAgain(KplContext *ctx)
 {
-  while (lookAhead->tokenType == SB_LSEL)
+  int lazyBodies = ctx->lazyBodies;
+
+  cleanSymTab(ctx);
+  freeAst(ctx->ast);
+  ctx->ast = createAst(ctx->tokens->count);
+  ctx->tokenIndex = 0;
+  initSymTab(ctx);
+  ctx->lazyBodies = 0;
+  parseProgram(ctx);
+  ctx->lazyBodies = lazyBodies;
+}
+
+// Parses the bodies of the subprograms of the program in parallel. When
+// one of them fails, or anything else does, the program is parsed again
+// from the start, sequentially, for the errors to be reported as usual.
+void parseProgramParallel(KplContext *ctx)
+{
+  int failed;
+
+  initSymTab(ctx);
+  ctx->bodyQueue = createBodyQueue();
+  parseProgram(ctx);
+  failed = ctx->bodyQueue->failed || (ctx->diagnosticCount > 0);
+  freeBodyQueue(ctx->bodyQueue);
+  ctx->bodyQueue = NULL;
+  if (!failed)
+    return;
+
+  parseProgramAgain(ctx);
+}
+
+// Parses the input of ctx into a new tree and, unless only the syntax is
+// checked, a new symbol table, in the mode ctx asks for
+void parseInput(KplContext *ctx)
+{
+  if (ctx->syntaxOnly)
+    ctx->ast = createScratchAst();
+  else if (ctx->tokens != NULL)
+    ctx->ast = createAst(ctx->tokens->count);
+  // Without the tokens, a guess at their number
+  else ctx->ast = createAst((ctx->inputEnd - ctx->inputBuffer) / 4);
+
+  if (ctx->tableParser && (ctx->tokens != NULL))
+    parseProgramTable(ctx);
+  else if (ctx->syntaxOnly)
+    parseProgram(ctx);
+  else if ((ctx->parseThreads > 1) && (ctx->tokens != NULL) && !ctx->lazyBodies)
+    parseProgramParallel(ctx);
+  else
   {
-    eat(SB_LSEL);
-    compileExpression();
-    eat(SB_RSEL);
+    initSymTab(ctx);
+    parseProgram(ctx);
+    // Lazily, only the trees to print are parsed
+    if (ctx->lazyBodies && ctx->printAst && (ctx->symtab->program != NULL))
+      compileLazyBodies(ctx, ctx->symtab->program);
+    // Recovery does not stop where a statement part left for later does,
+    // so once there are errors the program is parsed again, every body in
+    // place, for them to be those of a sequential parse
+    if (ctx->lazyBodies && (ctx->diagnosticCount > 0) && (ctx->tokens != NULL))
+      parseProgramAgain(ctx);
   }
 }
 
-int compile(char *fileName)
+// Reads and parses a program, which stays open for closeProgram()
+int openProgram(KplContext *ctx, char *fileName)
 {
-  if (openInputStream(fileName) == IO_ERROR)
+  if (openInputStream(ctx, fileName) == IO_ERROR)
     return IO_ERROR;
 
-  currentToken = NULL;
-  lookAhead = getValidToken();
+  // Syntax-only mode looks no identifier up, so it does not intern them
+  // either, unless they go to the token cache. Its trees are thrown away.
+  if (ctx->syntaxOnly && !ctx->tokenCache)
+  {
+    freeInterner(ctx->interner);
+    ctx->interner = NULL;
+  }
+
+  ctx->tokens = NULL;
+  if (ctx->preTokenize)
+    pretokenize(ctx, fileName);
+  parseInput(ctx);
+  return IO_SUCCESS;
+}
 
-  initSymTab();
+void closeProgram(KplContext *ctx)
+{
+  if (!ctx->syntaxOnly)
+    cleanSymTab(ctx);
+
+  freeTokenBuffer(ctx->tokens);
+  ctx->tokens = NULL;
+  freeAst(ctx->ast);
+  ctx->ast = NULL;
+  closeInputStream(ctx);
+}
 
-  compileProgram();
+int compile(KplContext *ctx, char *fileName)
+{
+  int pending;
 
-  printObject(symtab->program, 0);
+  if (openProgram(ctx, fileName) == IO_ERROR)
+    return IO_ERROR;
 
-  cleanSymTab();
+  if (ctx->diagnosticCount > 0)
+    printDiagnostics(ctx);
+  else if (!ctx->syntaxOnly)
+  {
+    // Lazily, the statement parts no one asked for were not checked
+    pending = pendingBodies(ctx->symtab->program);
+    if (pending > 0)
+      printf("Declarations only, subprogram bodies not checked: %d\n", pending);
+    printObject(ctx->symtab->program, 0);
+    if (ctx->printAst)
+      printBodies(ctx->ast, ctx->symtab, ctx->symtab->program, 0);
+  }
 
-  free(currentToken);
-  free(lookAhead);
-  closeInputStream();
+  closeProgram(ctx);
   return IO_SUCCESS;
 }
@@ -5,55 +5,75 @@
  */
 #ifndef __PARSER_H__
 #define __PARSER_H__
+#include "context.h"
 #include "token.h"
 #include "symtab.h"
+#include "ast.h"
+#include "tokenbuffer.h"
 
-void scan(void);
-void eat(TokenType tokenType);
+void scan(KplContext *ctx);
+void eat(KplContext *ctx, TokenType tokenType);
+void skipTo(KplContext *ctx, TokenSet sync);
+NodeId compileGuardedStatement(KplContext *ctx, int *resumed);
+void compileGuardedDeclaration(KplContext *ctx, void (*compileDeclaration)(KplContext *ctx));
+int skimBlock(KplContext *ctx);
+void skipToToken(KplContext *ctx, int index);
+int deferBlock(KplContext *ctx, Object *owner);
+int skimStatements(TokenBuffer *tokens, int first);
+int deferStatements(KplContext *ctx);
+void compileSubprogramBlock(KplContext *ctx, Object *owner);
+NodeId tokenNode(KplContext *ctx, enum NodeKind kind);
+NodeId objectNode(KplContext *ctx, enum NodeKind kind, Object *obj, int arguments);
+NodeId operatorNode(KplContext *ctx, enum NodeKind kind, TokenType op, NodeId left, NodeId right);
 
-void compileProgram(void);
-void compileBlock(void);
-void compileBlock2(void);
-void compileBlock3(void);
-void compileBlock4(void);
-void compileBlock5(void);
-void compileConstDecls(void);
-void compileConstDecl(void);
-void compileTypeDecls(void);
-void compileTypeDecl(void);
-void compileVarDecls(void);
-void compileVarDecl(void);
-void compileSubDecls(void);
-void compileFuncDecl(void);
-void compileProcDecl(void);
-ConstantValue* compileUnsignedConstant(void);
-ConstantValue* compileConstant(void);
-ConstantValue* compileConstant2(void);
-Type* compileType(void);
-Type* compileBasicType(void);
-void compileParams(void);
-void compileParam(void);
-void compileStatements(void);
-void compileStatement(void);
-void compileLValue(void);
-void compileAssignSt(void);
-void compileCallSt(void);
-void compileGroupSt(void);
-void compileIfSt(void);
-void compileElseSt(void);
-void compileWhileSt(void);
-void compileForSt(void);
-void compileArgument(void);
-void compileArguments(void);
-void compileCondition(void);
-void compileExpression(void);
-void compileExpression2(void);
-void compileExpression3(void);
-void compileTerm(void);
-void compileTerm2(void);
-void compileFactor(void);
-void compileIndexes(void);
+void compileProgram(KplContext *ctx);
+NodeId compileBlock(KplContext *ctx);
+NodeId compileBlock2(KplContext *ctx);
+NodeId compileBlock3(KplContext *ctx);
+NodeId compileBlock4(KplContext *ctx);
+NodeId compileBlock5(KplContext *ctx);
+void compileConstDecls(KplContext *ctx);
+void compileConstDecl(KplContext *ctx);
+void compileTypeDecls(KplContext *ctx);
+void compileTypeDecl(KplContext *ctx);
+void compileVarDecls(KplContext *ctx);
+void compileVarDecl(KplContext *ctx);
+void compileSubDecls(KplContext *ctx);
+void compileFuncDecl(KplContext *ctx);
+void compileProcDecl(KplContext *ctx);
+ConstantValue* compileUnsignedConstant(KplContext *ctx);
+ConstantValue* compileConstant(KplContext *ctx);
+ConstantValue* compileConstant2(KplContext *ctx);
+Type* compileType(KplContext *ctx);
+Type* compileBasicType(KplContext *ctx);
+void compileParams(KplContext *ctx);
+void compileParam(KplContext *ctx);
+int compileStatements(KplContext *ctx);
+NodeId compileStatement(KplContext *ctx);
+NodeId compileLValue(KplContext *ctx);
+NodeId compileAssignSt(KplContext *ctx);
+NodeId compileCallSt(KplContext *ctx);
+NodeId compileGroupSt(KplContext *ctx);
+NodeId compileIfSt(KplContext *ctx);
+NodeId compileElseSt(KplContext *ctx);
+NodeId compileWhileSt(KplContext *ctx);
+NodeId compileForSt(KplContext *ctx);
+NodeId compileArgument(KplContext *ctx);
+int compileArguments(KplContext *ctx);
+NodeId compileCondition(KplContext *ctx);
+NodeId compileExpression(KplContext *ctx);
+NodeId compileFactor(KplContext *ctx);
+NodeId compileIndexes(KplContext *ctx, NodeId base);
 
-int compile(char *fileName);
+NodeId subprogramBody(KplContext *ctx, Object *subprogram);
+void compileLazyBodies(KplContext *ctx, Object *obj);
+int pendingBodies(Object *obj);
+void parseProgram(KplContext *ctx);
+void parseProgramAgain(KplContext *ctx);
+void parseProgramParallel(KplContext *ctx);
+void parseInput(KplContext *ctx);
+int openProgram(KplContext *ctx, char *fileName);
+void closeProgram(KplContext *ctx);
+int compile(KplContext *ctx, char *fileName);
 
 #endif
@@ -5,33 +5,219 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "reader.h"
 
-FILE *inputStream;
-int lineNo, colNo;
-int currentChar;
+#define READ_CHUNK_SIZE 65536
+#define LINE_TABLE_SIZE 1024
 
-int readChar(void) {
-  currentChar = getc(inputStream);
-  colNo ++;
-  if (currentChar == '\n') {
-    lineNo ++;
-    colNo = 0;
+int readChar(KplContext *ctx) {
+  if (ctx->inputPtr < ctx->inputEnd)
+    ctx->currentChar = (unsigned char) *ctx->inputPtr++;
+  else ctx->currentChar = EOF;
+  return ctx->currentChar;
+}
+
+// Builds the line index (offsets of the first character of every line)
+// in one pass; memchr does the newline search a machine word (or vector)
+// at a time.
+int buildLineIndex(KplContext *ctx) {
+  int capacity = LINE_TABLE_SIZE;
+  char *p = ctx->inputBuffer;
+
+  ctx->lineStarts = (int*) malloc(capacity * sizeof(int));
+  if (ctx->lineStarts == NULL)
+    return IO_ERROR;
+  ctx->lineStarts[0] = 0;
+  ctx->lineCount = 1;
+
+  while ((p = memchr(p, '\n', ctx->inputEnd - p)) != NULL) {
+    p ++;
+    if (ctx->lineCount == capacity) {
+      int *grown = (int*) realloc(ctx->lineStarts, capacity * 2 * sizeof(int));
+      if (grown == NULL)
+	return IO_ERROR;
+      ctx->lineStarts = grown;
+      capacity *= 2;
+    }
+    ctx->lineStarts[ctx->lineCount++] = p - ctx->inputBuffer;
+  }
+  return IO_SUCCESS;
+}
+
+void getPosition(KplContext *ctx, int offset, int *lineNo, int *colNo) {
+  int lo = 0, hi = ctx->lineCount - 1;
+
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    if (ctx->lineStarts[mid] <= offset) lo = mid;
+    else hi = mid - 1;
+  }
+  *lineNo = lo + 1;
+  *colNo = offset - ctx->lineStarts[lo] + 1;
+}
+
+// Fallback for inputs that cannot be mapped: slurp everything into a
+// growing heap buffer.
+int readWholeStream(KplContext *ctx, int fd) {
+  size_t size = 0;
+  size_t capacity = READ_CHUNK_SIZE;
+  char *buffer = (char*) malloc(capacity);
+  ssize_t n;
+
+  if (buffer == NULL)
+    return IO_ERROR;
+
+  while ((n = read(fd, buffer + size, capacity - size)) != 0) {
+    if (n < 0) {
+      free(buffer);
+      return IO_ERROR;
+    }
+    size += n;
+    if (size == capacity) {
+      char *grown = (char*) realloc(buffer, capacity * 2);
+      if (grown == NULL) {
+	free(buffer);
+	return IO_ERROR;
+      }
+      buffer = grown;
+      capacity *= 2;
+    }
+  }
+
+  ctx->inputBuffer = buffer;
+  ctx->inputEnd = buffer + size;
+  ctx->inputMapped = 0;
+  return IO_SUCCESS;
+}
+
+int openInputStream(KplContext *ctx, char *fileName) {
+  struct stat st;
+  int fd = open(fileName, O_RDONLY);
+  int result = IO_SUCCESS;
+
+  if (fd < 0)
+    return IO_ERROR;
+
+  ctx->inputBuffer = MAP_FAILED;
+  if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0))
+    ctx->inputBuffer = (char*) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (ctx->inputBuffer != MAP_FAILED) {
+    ctx->inputEnd = ctx->inputBuffer + st.st_size;
+    ctx->inputMapped = 1;
+  } else result = readWholeStream(ctx, fd);
+
+  close(fd);
+  if (result == IO_ERROR)
+    return IO_ERROR;
+
+  if (buildLineIndex(ctx) == IO_ERROR) {
+    closeInputStream(ctx);
+    return IO_ERROR;
+  }
+
+  ctx->inputPtr = ctx->inputBuffer;
+  readChar(ctx);
+  return IO_SUCCESS;
+}
+
+// Index of the first line that starts after offset
+int firstLineAfter(KplContext *ctx, int offset) {
+  int lo = 0, hi = ctx->lineCount;
+
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (ctx->lineStarts[mid] <= offset) lo = mid + 1;
+    else hi = mid;
   }
-  return currentChar;
+  return lo;
+}
+
+// Whether replacing the removed characters at start with length others
+// stays inside the input, and the input within the size of an offset
+int editFits(KplContext *ctx, int start, int removed, int length) {
+  int size = ctx->inputEnd - ctx->inputBuffer;
+
+  return (start >= 0) && (removed >= 0) && (removed <= size - start) &&
+    (length >= 0) && (length < INT_MAX - (size - removed));
 }
 
-int openInputStream(char *fileName) {
-  inputStream = fopen(fileName, "rt");
-  if (inputStream == NULL)
+// Replaces the removed characters at start with the length characters
+// of text, in memory only; a mapped input is moved to the heap first.
+// The line index is patched: the lines that start inside the replaced
+// characters give way to those of text, and the later ones are shifted.
+// The reader is left at the beginning of the input. An edit that is not
+// inside the input is refused before anything changes.
+int editInput(KplContext *ctx, int start, int removed, char *text, int length) {
+  int size = ctx->inputEnd - ctx->inputBuffer;
+  int newSize, capacity, first, last;
+  int added = 0, lineCount, i;
+  int *lineStarts;
+  char *buffer;
+
+  if (!editFits(ctx, start, removed, length))
+    return IO_ERROR;
+  newSize = size - removed + length;
+  capacity = (newSize > size) ? newSize : size;
+  first = firstLineAfter(ctx, start);
+  last = firstLineAfter(ctx, start + removed);
+
+  for (i = 0; i < length; i++)
+    if (text[i] == '\n')
+      added ++;
+  lineCount = ctx->lineCount - (last - first) + added;
+
+  if (ctx->inputMapped) {
+    buffer = (char*) malloc(capacity + 1);
+    if (buffer != NULL)
+      memcpy(buffer, ctx->inputBuffer, size);
+  } else buffer = (char*) realloc(ctx->inputBuffer, capacity + 1);
+  if (buffer == NULL)
     return IO_ERROR;
-  lineNo = 1;
-  colNo = 0;
-  readChar();
+  if (ctx->inputMapped) {
+    munmap(ctx->inputBuffer, size);
+    ctx->inputMapped = 0;
+  }
+  ctx->inputBuffer = buffer;
+
+  if (lineCount > ctx->lineCount) {
+    lineStarts = (int*) realloc(ctx->lineStarts, lineCount * sizeof(int));
+    if (lineStarts == NULL)
+      return IO_ERROR;
+    ctx->lineStarts = lineStarts;
+  }
+
+  memmove(buffer + start + length, buffer + start + removed, size - start - removed);
+  memcpy(buffer + start, text, length);
+  ctx->inputEnd = buffer + newSize;
+
+  lineStarts = ctx->lineStarts;
+  memmove(lineStarts + first + added, lineStarts + last, (ctx->lineCount - last) * sizeof(int));
+  for (i = first + added; i < lineCount; i++)
+    lineStarts[i] += length - removed;
+  for (i = 0; i < length; i++)
+    if (text[i] == '\n')
+      lineStarts[first++] = start + i + 1;
+  ctx->lineCount = lineCount;
+
+  ctx->inputPtr = ctx->inputBuffer;
+  readChar(ctx);
   return IO_SUCCESS;
 }
 
-void closeInputStream() {
-  fclose(inputStream);
+void closeInputStream(KplContext *ctx) {
+  if (ctx->inputMapped)
+    munmap(ctx->inputBuffer, ctx->inputEnd - ctx->inputBuffer);
+  else free(ctx->inputBuffer);
+  free(ctx->lineStarts);
+  ctx->inputBuffer = ctx->inputPtr = ctx->inputEnd = NULL;
+  ctx->lineStarts = NULL;
 }
 
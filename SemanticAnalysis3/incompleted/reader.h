@@ -7,11 +7,21 @@
 #ifndef __READER_H__
 #define __READER_H__
 
+#include "context.h"
+
 #define IO_ERROR 0
 #define IO_SUCCESS 1
 
-int readChar(void);
-int openInputStream(char *fileName);
-void closeInputStream(void);
+// The whole source is kept resident in memory: it is mapped when the
+// input is a regular file and read into a heap buffer otherwise (pipes,
+// character devices). The scanner walks it with a plain pointer; line and
+// column numbers are only computed on demand from a line-start index.
+
+int readChar(KplContext *ctx);
+void getPosition(KplContext *ctx, int offset, int *lineNo, int *colNo);
+int openInputStream(KplContext *ctx, char *fileName);
+void closeInputStream(KplContext *ctx);
+int editFits(KplContext *ctx, int start, int removed, int length);
+int editInput(KplContext *ctx, int start, int removed, char *text, int length);
 
 #endif
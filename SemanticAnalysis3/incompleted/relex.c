@@ -0,0 +1,115 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// Incremental scanning for editors. The scanner has no state besides its
+// position, so between two tokens it does not matter how it got there:
+//
+// - It can restart at the end of any token that is followed by at least
+//   one character before the edit, the one that ended the token. Blanks,
+//   comments and char constants after that point are scanned again, so an
+//   edit that opens or closes a comment or a quote is seen.
+//
+// - Once it produces a token after the edit at the shifted offset of an
+//   old token, the rest of the old stream is what it would produce: the
+//   old entries are kept, and only their offsets change.
+//
+// Errors end a stream, and whether they happen depends on text after
+// their offset, so they are never reused.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+#include "relex.h"
+
+// Moves count entries from index from to index to
+void moveTokens(TokenBuffer *tokens, int to, int from, int count) {
+  memmove(tokens->types + to, tokens->types + from, count * sizeof(unsigned char));
+  memmove(tokens->offsets + to, tokens->offsets + from, count * sizeof(int));
+  memmove(tokens->lengths + to, tokens->lengths + from, count * sizeof(int));
+  memmove(tokens->values + to, tokens->values + from, count * sizeof(int));
+}
+
+// Number of leading entries that end before start and can be kept
+int keptTokens(TokenBuffer *tokens, int start) {
+  int lo = 0, hi = tokens->count;
+
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (tokens->offsets[mid] + tokens->lengths[mid] < start) lo = mid + 1;
+    else hi = mid;
+  }
+  // The last entry is TK_EOF or an error
+  if (lo == tokens->count)
+    lo --;
+  return lo;
+}
+
+// Applies the edit to the input of ctx (see editInput) and brings tokens,
+// the stream of the input before the edit, up to date
+int relexEdit(KplContext *ctx, TokenBuffer *tokens, int start, int removed,
+	      char *text, int length, TokenRange *range) {
+  int delta = length - removed;
+  int first = keptTokens(tokens, start);
+  int restart = (first > 0) ? tokens->offsets[first - 1] + tokens->lengths[first - 1] : 0;
+  int synced = tokens->count;
+  TokenBuffer *fresh;
+  jmp_buf outerJump;
+  TokenType tokenType;
+  int offset, tokenLength, value;
+  int j, count;
+  int *tail, *end;
+
+  if (editInput(ctx, start, removed, text, length) == IO_ERROR)
+    return IO_ERROR;
+
+  ctx->inputPtr = ctx->inputBuffer + restart;
+  readChar(ctx);
+
+  fresh = createTokenBuffer(0);
+  memcpy(outerJump, ctx->errorJump, sizeof(jmp_buf));
+  ctx->recordErrors = 1;
+  j = first;
+  for (;;) {
+    scanOne(ctx, &tokenType, &offset, &tokenLength, &value);
+    if ((tokenType != TK_NONE) && (offset >= start + length)) {
+      while ((j < tokens->count) && (tokens->offsets[j] < offset - delta))
+	j ++;
+      if ((j < tokens->count) && (tokens->offsets[j] == offset - delta) && (tokens->types[j] != TK_NONE)) {
+	synced = j;
+	break;
+      }
+    }
+    appendToken(fresh, tokenType, offset, tokenLength, value);
+    if ((tokenType == TK_EOF) || (tokenType == TK_NONE))
+      break;
+  }
+  ctx->recordErrors = 0;
+  memcpy(ctx->errorJump, outerJump, sizeof(jmp_buf));
+
+  // Splice: kept head, fresh tokens, shifted tail. The tail is most of
+  // the stream, and stays where it is as long as the number of tokens does.
+  count = tokens->count - synced;
+  while (first + fresh->count + count > tokens->capacity)
+    growTokenBuffer(tokens, 2 * tokens->capacity);
+  if (first + fresh->count != synced)
+    moveTokens(tokens, first + fresh->count, synced, count);
+  if (delta != 0)
+    for (tail = tokens->offsets + first + fresh->count, end = tail + count; tail < end; tail++)
+      *tail += delta;
+  memcpy(tokens->types + first, fresh->types, fresh->count * sizeof(unsigned char));
+  memcpy(tokens->offsets + first, fresh->offsets, fresh->count * sizeof(int));
+  memcpy(tokens->lengths + first, fresh->lengths, fresh->count * sizeof(int));
+  memcpy(tokens->values + first, fresh->values, fresh->count * sizeof(int));
+
+  range->first = first;
+  range->removedCount = synced - first;
+  range->insertedCount = fresh->count;
+  tokens->count = first + fresh->count + count;
+
+  freeTokenBuffer(fresh);
+  return IO_SUCCESS;
+}
@@ -0,0 +1,25 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __RELEX_H__
+#define __RELEX_H__
+
+#include "context.h"
+#include "tokenbuffer.h"
+
+// What relexEdit did to the token stream: the removedCount entries from
+// first on were replaced by insertedCount new ones; the entries after
+// them are the old ones, shifted by the change in length.
+typedef struct {
+  int first;
+  int removedCount;
+  int insertedCount;
+} TokenRange;
+
+int relexEdit(KplContext *ctx, TokenBuffer *tokens, int start, int removed,
+	      char *text, int length, TokenRange *range);
+
+#endif
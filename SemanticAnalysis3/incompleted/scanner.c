@@ -6,255 +6,268 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <limits.h>
 
 #include "reader.h"
 #include "charcode.h"
 #include "token.h"
 #include "error.h"
 #include "scanner.h"
+#include "fastskip.h"
+#include "interner.h"
 
 
-extern int lineNo;
-extern int colNo;
-extern int currentChar;
-
 extern CharCode charCodes[];
 
 /***************************************************************/
 
-void skipBlank() {
-  while ((currentChar != EOF) && (charCodes[currentChar] == CHAR_SPACE))
-    readChar();
+// Offset of the current character in the source buffer
+int currentOffset(KplContext *ctx) {
+  if (ctx->currentChar == EOF)
+    return ctx->inputEnd - ctx->inputBuffer;
+  return ctx->inputPtr - ctx->inputBuffer - 1;
 }
 
-void skipComment() {
-  int state = 0;
-  while ((currentChar != EOF) && (state < 2)) {
-    switch (charCodes[currentChar]) {
-    case CHAR_TIMES:
-      state = 1;
-      break;
-    case CHAR_RPAR:
-      if (state == 1) state = 2;
-      else state = 0;
-      break;
-    default:
-      state = 0;
-    }
-    readChar();
-  }
-  if (state != 2) 
-    error(ERR_END_OF_COMMENT, lineNo, colNo);
+// Both skips hand the run to fastskip.c and resume reading after it
+void skipBlank(KplContext *ctx) {
+  if (ctx->currentChar == EOF)
+    return;
+  ctx->inputPtr = skipSpaces(ctx->inputPtr - 1, ctx->inputEnd);
+  readChar(ctx);
 }
 
-Token* readIdentKeyword(void) {
-  Token *token = makeToken(TK_NONE, lineNo, colNo);
-  int count = 1;
+void skipComment(KplContext *ctx) {
+  char *end;
 
-  token->string[0] = toupper((char)currentChar);
-  readChar();
+  if (ctx->currentChar == EOF)
+    end = NULL;
+  else end = findCommentEnd(ctx->inputPtr - 1, ctx->inputEnd);
 
-  while ((currentChar != EOF) && 
-	 ((charCodes[currentChar] == CHAR_LETTER) || (charCodes[currentChar] == CHAR_DIGIT))) {
-    if (count <= MAX_IDENT_LEN) token->string[count++] = toupper((char)currentChar);
-    readChar();
+  if (end == NULL) {
+    ctx->inputPtr = ctx->inputEnd;
+    readChar(ctx);
+    error(ctx, ERR_END_OF_COMMENT, currentOffset(ctx));
+    return;
   }
+  ctx->inputPtr = end;
+  readChar(ctx);
+}
 
-  if (count > MAX_IDENT_LEN) {
-    error(ERR_IDENT_TOO_LONG, token->lineNo, token->colNo);
-    return token;
-  }
+Token readIdentKeyword(KplContext *ctx) {
+  int offset = currentOffset(ctx);
+  int length;
+  TokenType tokenType;
 
-  token->string[count] = '\0';
-  token->tokenType = checkKeyword(token->string);
+  readChar(ctx);
+  while ((ctx->currentChar != EOF) && 
+	 ((charCodes[ctx->currentChar] == CHAR_LETTER) || (charCodes[ctx->currentChar] == CHAR_DIGIT)))
+    readChar(ctx);
 
-  if (token->tokenType == TK_NONE)
-    token->tokenType = TK_IDENT;
+  length = currentOffset(ctx) - offset;
+  tokenType = checkKeyword(ctx->inputBuffer + offset, length);
 
-  return token;
+  if (tokenType == TK_NONE) {
+    if (ctx->interner != NULL)
+      return makeToken(TK_IDENT, offset, internName(ctx->interner, ctx->inputBuffer + offset, length));
+    return makeToken(TK_IDENT, offset, 0);
+  }
+
+  return makeToken(tokenType, offset, 0);
 }
 
-Token* readNumber(void) {
-  Token *token = makeToken(TK_NUMBER, lineNo, colNo);
-  int count = 0;
+// The value of a run of digits, -1 when it is more than an int holds
+int digitsValue(char *digits, int length) {
+  int value = 0, digit, i;
 
-  while ((currentChar != EOF) && (charCodes[currentChar] == CHAR_DIGIT)) {
-    token->string[count++] = (char)currentChar;
-    readChar();
+  for (i = 0; i < length; i++) {
+    digit = digits[i] - '0';
+    if (value > (INT_MAX - digit) / 10)
+      return -1;
+    value = value * 10 + digit;
   }
+  return value;
+}
 
-  token->string[count] = '\0';
-  token->value = atoi(token->string);
-  return token;
+Token readNumber(KplContext *ctx) {
+  int offset = currentOffset(ctx);
+  int value;
+
+  while ((ctx->currentChar != EOF) && (charCodes[ctx->currentChar] == CHAR_DIGIT))
+    readChar(ctx);
+
+  value = digitsValue(ctx->inputBuffer + offset, currentOffset(ctx) - offset);
+  if (value < 0) {
+    error(ctx, ERR_NUMBER_TOO_LARGE, offset);
+    return makeToken(TK_NONE, offset, 0);
+  }
+  return makeToken(TK_NUMBER, offset, value);
 }
 
-Token* readConstChar(void) {
-  Token *token = makeToken(TK_CHAR, lineNo, colNo);
+Token readConstChar(KplContext *ctx) {
+  int offset = currentOffset(ctx);
+  int value;
 
-  readChar();
-  if (currentChar == EOF) {
-    token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
-    return token;
+  readChar(ctx);
+  if (ctx->currentChar == EOF) {
+    error(ctx, ERR_INVALID_CONSTANT_CHAR, offset);
+    return makeToken(TK_NONE, offset, 0);
   }
     
-  token->string[0] = currentChar;
-  token->string[1] = '\0';
-
-  readChar();
-  if (currentChar == EOF) {
-    token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
-    return token;
+  value = ctx->currentChar;
+
+  readChar(ctx);
+  if (ctx->currentChar == EOF) {
+    error(ctx, ERR_INVALID_CONSTANT_CHAR, offset);
+    return makeToken(TK_NONE, offset, 0);
   }
 
-  if (charCodes[currentChar] == CHAR_SINGLEQUOTE) {
-    readChar();
-    return token;
+  if (charCodes[ctx->currentChar] == CHAR_SINGLEQUOTE) {
+    readChar(ctx);
+    return makeToken(TK_CHAR, offset, value);
   } else {
-    token->tokenType = TK_NONE;
-    error(ERR_INVALID_CONSTANT_CHAR, token->lineNo, token->colNo);
-    return token;
+    error(ctx, ERR_INVALID_CONSTANT_CHAR, offset);
+    return makeToken(TK_NONE, offset, 0);
+  }
+}
+
+// A one character symbol
+Token readSymbol(KplContext *ctx, TokenType tokenType) {
+  Token token = makeToken(tokenType, currentOffset(ctx), 0);
+
+  readChar(ctx);
+  return token;
+}
+
+// A symbol of one character that becomes another one when followed by
+// the character of class second, like < and <=
+Token readPairedSymbol(KplContext *ctx, CharCode second, TokenType single, TokenType pair) {
+  int pos = currentOffset(ctx);
+
+  readChar(ctx);
+  if ((ctx->currentChar != EOF) && (charCodes[ctx->currentChar] == second)) {
+    readChar(ctx);
+    return makeToken(pair, pos, 0);
   }
+  return makeToken(single, pos, 0);
 }
 
-Token* getToken(void) {
-  Token *token;
-  int ln, cn;
-
-  if (currentChar == EOF) 
-    return makeToken(TK_EOF, lineNo, colNo);
-
-  switch (charCodes[currentChar]) {
-  case CHAR_SPACE: skipBlank(); return getToken();
-  case CHAR_LETTER: return readIdentKeyword();
-  case CHAR_DIGIT: return readNumber();
-  case CHAR_PLUS: 
-    token = makeToken(SB_PLUS, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_MINUS:
-    token = makeToken(SB_MINUS, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_TIMES:
-    token = makeToken(SB_TIMES, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_SLASH:
-    token = makeToken(SB_SLASH, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_LT:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_LE, ln, cn);
-    } else return makeToken(SB_LT, ln, cn);
-  case CHAR_GT:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_GE, ln, cn);
-    } else return makeToken(SB_GT, ln, cn);
-  case CHAR_EQ: 
-    token = makeToken(SB_EQ, lineNo, colNo);
-    readChar(); 
-    return token;
+Token getToken(KplContext *ctx) {
+  int pos;
+
+  if (ctx->currentChar == EOF)
+    return makeToken(TK_EOF, currentOffset(ctx), 0);
+
+  switch (charCodes[ctx->currentChar]) {
+  case CHAR_SPACE: skipBlank(ctx); return getToken(ctx);
+  case CHAR_LETTER: return readIdentKeyword(ctx);
+  case CHAR_DIGIT: return readNumber(ctx);
+  case CHAR_PLUS: return readSymbol(ctx, SB_PLUS);
+  case CHAR_MINUS: return readSymbol(ctx, SB_MINUS);
+  case CHAR_TIMES: return readSymbol(ctx, SB_TIMES);
+  case CHAR_SLASH: return readSymbol(ctx, SB_SLASH);
+  case CHAR_LT: return readPairedSymbol(ctx, CHAR_EQ, SB_LT, SB_LE);
+  case CHAR_GT: return readPairedSymbol(ctx, CHAR_EQ, SB_GT, SB_GE);
+  case CHAR_EQ: return readSymbol(ctx, SB_EQ);
   case CHAR_EXCLAIMATION:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_NEQ, ln, cn);
+    pos = currentOffset(ctx);
+    readChar(ctx);
+    if ((ctx->currentChar != EOF) && (charCodes[ctx->currentChar] == CHAR_EQ)) {
+      readChar(ctx);
+      return makeToken(SB_NEQ, pos, 0);
     } else {
-      token = makeToken(TK_NONE, ln, cn);
-      error(ERR_INVALID_SYMBOL, ln, cn);
-      return token;
+      error(ctx, ERR_INVALID_SYMBOL, pos);
+      return makeToken(TK_NONE, pos, 0);
     }
-  case CHAR_COMMA:
-    token = makeToken(SB_COMMA, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_PERIOD:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_RPAR)) {
-      readChar();
-      return makeToken(SB_RSEL, ln, cn);
-    } else return makeToken(SB_PERIOD, ln, cn);
-  case CHAR_SEMICOLON:
-    token = makeToken(SB_SEMICOLON, lineNo, colNo);
-    readChar(); 
-    return token;
-  case CHAR_COLON:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
-    if ((currentChar != EOF) && (charCodes[currentChar] == CHAR_EQ)) {
-      readChar();
-      return makeToken(SB_ASSIGN, ln, cn);
-    } else return makeToken(SB_COLON, ln, cn);
-  case CHAR_SINGLEQUOTE: return readConstChar();
+  case CHAR_COMMA: return readSymbol(ctx, SB_COMMA);
+  case CHAR_PERIOD: return readPairedSymbol(ctx, CHAR_RPAR, SB_PERIOD, SB_RSEL);
+  case CHAR_SEMICOLON: return readSymbol(ctx, SB_SEMICOLON);
+  case CHAR_COLON: return readPairedSymbol(ctx, CHAR_EQ, SB_COLON, SB_ASSIGN);
+  case CHAR_SINGLEQUOTE: return readConstChar(ctx);
   case CHAR_LPAR:
-    ln = lineNo;
-    cn = colNo;
-    readChar();
+    pos = currentOffset(ctx);
+    readChar(ctx);
 
-    if (currentChar == EOF) 
-      return makeToken(SB_LPAR, ln, cn);
+    if (ctx->currentChar == EOF) 
+      return makeToken(SB_LPAR, pos, 0);
 
-    switch (charCodes[currentChar]) {
+    switch (charCodes[ctx->currentChar]) {
     case CHAR_PERIOD:
-      readChar();
-      return makeToken(SB_LSEL, ln, cn);
+      readChar(ctx);
+      return makeToken(SB_LSEL, pos, 0);
     case CHAR_TIMES:
-      readChar();
-      skipComment();
-      return getToken();
+      readChar(ctx);
+      skipComment(ctx);
+      return getToken(ctx);
     default:
-      return makeToken(SB_LPAR, ln, cn);
+      return makeToken(SB_LPAR, pos, 0);
     }
-  case CHAR_RPAR:
-    token = makeToken(SB_RPAR, lineNo, colNo);
-    readChar(); 
-    return token;
+  case CHAR_RPAR: return readSymbol(ctx, SB_RPAR);
   default:
-    token = makeToken(TK_NONE, lineNo, colNo);
-    error(ERR_INVALID_SYMBOL, lineNo, colNo);
-    readChar(); 
-    return token;
+    pos = currentOffset(ctx);
+    error(ctx, ERR_INVALID_SYMBOL, pos);
+    readChar(ctx); 
+    return makeToken(TK_NONE, pos, 0);
   }
 }
 
-Token* getValidToken(void) {
-  Token *token = getToken();
-  while (token->tokenType == TK_NONE) {
-    free(token);
-    token = getToken();
-  }
+// Runs the scanner engine selected in the context
+Token nextToken(KplContext *ctx) {
+  if (ctx->dfaScanner)
+    return getTokenDfa(ctx);
+  return getToken(ctx);
+}
+
+Token getValidToken(KplContext *ctx) {
+  Token token = nextToken(ctx);
+  while (token.tokenType == TK_NONE)
+    token = nextToken(ctx);
   return token;
 }
 
+// Both engines leave the reader on the first character after the token
+// they return, so its length is the distance to there
+int scannedLength(KplContext *ctx, Token token) {
+  return currentOffset(ctx) - token.offset;
+}
+
+// The length of the lexeme at offset made of the characters of class
+// first and then of class first or other
+int runLength(KplContext *ctx, int offset, CharCode first, CharCode other) {
+  int i = offset;
+
+  while ((ctx->inputBuffer + i < ctx->inputEnd) &&
+	 ((charCodes[(unsigned char) ctx->inputBuffer[i]] == first) ||
+	  ((i > offset) && (charCodes[(unsigned char) ctx->inputBuffer[i]] == other))))
+    i ++;
+  return i - offset;
+}
+
+// The upper case name of an identifier, as the interner keeps it, or
+// NULL when identifiers are scanned without one
+char* getIdentString(KplContext *ctx, Token token) {
+  if (ctx->interner == NULL)
+    return NULL;
+  return symbolName(ctx->interner, token.value);
+}
 
 /******************************************************************/
 
-void printToken(Token *token) {
+void printToken(KplContext *ctx, Token token) {
+
+  int lineNo, colNo;
 
-  printf("%d-%d:", token->lineNo, token->colNo);
+  getPosition(ctx, token.offset, &lineNo, &colNo);
+  printf("%d-%d:", lineNo, colNo);
 
-  switch (token->tokenType) {
+  switch (token.tokenType) {
   case TK_NONE: printf("TK_NONE\n"); break;
-  case TK_IDENT: printf("TK_IDENT(%s)\n", token->string); break;
-  case TK_NUMBER: printf("TK_NUMBER(%s)\n", token->string); break;
-  case TK_CHAR: printf("TK_CHAR(\'%s\')\n", token->string); break;
+  case TK_IDENT:
+    if (ctx->interner != NULL)
+      printf("TK_IDENT(%s)\n", getIdentString(ctx, token));
+    else printf("TK_IDENT(%.*s)\n", runLength(ctx, token.offset, CHAR_LETTER, CHAR_DIGIT), ctx->inputBuffer + token.offset);
+    break;
+  case TK_NUMBER: printf("TK_NUMBER(%.*s)\n", runLength(ctx, token.offset, CHAR_DIGIT, CHAR_DIGIT), ctx->inputBuffer + token.offset); break;
+  case TK_CHAR: printf("TK_CHAR(\'%c\')\n", token.value); break;
   case TK_EOF: printf("TK_EOF\n"); break;
 
   case KW_PROGRAM: printf("KW_PROGRAM\n"); break;
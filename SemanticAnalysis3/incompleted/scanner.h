@@ -7,10 +7,16 @@
 #ifndef __SCANNER_H__
 #define __SCANNER_H__
 
+#include "context.h"
 #include "token.h"
 
-Token* getToken(void);
-Token* getValidToken(void);
-void printToken(Token *token);
+Token getToken(KplContext *ctx);
+Token getTokenDfa(KplContext *ctx);
+Token nextToken(KplContext *ctx);
+Token getValidToken(KplContext *ctx);
+int digitsValue(char *digits, int length);
+int scannedLength(KplContext *ctx, Token token);
+char* getIdentString(KplContext *ctx, Token token);
+void printToken(KplContext *ctx, Token token);
 
 #endif
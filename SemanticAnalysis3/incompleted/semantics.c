@@ -9,148 +9,135 @@
 #include "semantics.h"
 #include "error.h"
 
-extern SymTab *symtab;
-extern Token *currentToken;
-
-static int is_searching = 0;
+// A lookup walks the scope chain outwards from the current scope and ends
+// with the global object list. Each call resumes where the previous one
+// stopped, so that the checks below can skip objects of the wrong kind.
+// In each outer scope, only the objects up to the subprogram being
+// compiled are seen: the others are declared after it. A sequential parse
+// has not met them yet, but a body parsed late, in parallel or lazily,
+// would.
+void beginLookup(KplContext *ctx)
+{
+  ctx->lookupScope = ctx->symtab->currentScope;
+  ctx->lookupLimit = NULL;
+  ctx->lookupGlobals = 1;
+}
 
-Object *lookupObject(char *name)
+Object *lookupObject(KplContext *ctx, int symbol)
 {
   Object *obj = NULL;
-  static Scope *currScope = NULL;
 
-  if (is_searching == 0)
-    currScope = symtab->currentScope;
-
-  while (currScope != NULL)
+  while (ctx->lookupScope != NULL)
   {
-    is_searching = 1;
-    obj = findObject(currScope->objList, name);
+    obj = findObjectUpTo(ctx->lookupScope->objList, symbol, ctx->lookupLimit);
+    ctx->lookupLimit = ctx->lookupScope->owner;
+    ctx->lookupScope = ctx->lookupScope->outer;
     if (obj != NULL)
       return obj;
-    currScope = currScope->outer;
   }
 
-  is_searching = 0;
-  return findObject(symtab->globalObjectList, name);
+  if (ctx->lookupGlobals)
+  {
+    ctx->lookupGlobals = 0;
+    return findObject(ctx->symtab->globalObjectList, symbol);
+  }
+  return NULL;
+}
+
+// Looks for the innermost object named symbol whose kind is kind
+Object *lookupObjectOfKind(KplContext *ctx, int symbol, enum ObjectKind kind)
+{
+  Object *obj = NULL;
+
+  beginLookup(ctx);
+  do
+  {
+    obj = lookupObject(ctx, symbol);
+    if (obj != NULL && obj->kind == kind)
+      break;
+  } while (obj != NULL);
+
+  return obj;
 }
 
-void checkFreshIdent(char *name)
+void checkFreshIdent(KplContext *ctx, int symbol)
 {
-  Object *obj = findObject(symtab->currentScope->objList, currentToken->string);
+  Object *obj = findObject(ctx->symtab->currentScope->objList, symbol);
   if (obj != NULL)
-    error(ERR_DUPLICATE_IDENT, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_DUPLICATE_IDENT, ctx->currentToken.offset);
 }
 
-Object *checkDeclaredIdent(char *name)
+Object *checkDeclaredIdent(KplContext *ctx, int symbol)
 {
-  is_searching = 0; // start lookup, make sure it run
-  Object *obj = lookupObject(currentToken->string);
+  Object *obj;
+
+  beginLookup(ctx);
+  obj = lookupObject(ctx, symbol);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_IDENT, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_IDENT, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredConstant(char *name)
+Object *checkDeclaredConstant(KplContext *ctx, int symbol)
 {
-  Object *obj = NULL;
-
-  is_searching = 0;
-  do
-  {
-    obj = lookupObject(name);
-    if (obj != NULL && obj->kind == OBJ_CONSTANT)
-      break;
-  } while (obj != NULL);
+  Object *obj = lookupObjectOfKind(ctx, symbol, OBJ_CONSTANT);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_CONSTANT, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_CONSTANT, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredType(char *name)
+Object *checkDeclaredType(KplContext *ctx, int symbol)
 {
-  Object *obj = NULL;
-
-  is_searching = 0;
-  do
-  {
-    obj = lookupObject(name);
-    if (obj != NULL && obj->kind == OBJ_TYPE)
-      break;
-  } while (obj != NULL);
+  Object *obj = lookupObjectOfKind(ctx, symbol, OBJ_TYPE);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_TYPE, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_TYPE, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredVariable(char *name)
+Object *checkDeclaredVariable(KplContext *ctx, int symbol)
 {
-  Object *obj = NULL;
-
-  is_searching = 0;
-  do
-  {
-    obj = lookupObject(name);
-    if (obj != NULL && obj->kind == OBJ_VARIABLE)
-      break;
-  } while (obj != NULL);
+  Object *obj = lookupObjectOfKind(ctx, symbol, OBJ_VARIABLE);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_VARIABLE, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_VARIABLE, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredFunction(char *name)
+Object *checkDeclaredFunction(KplContext *ctx, int symbol)
 {
-  Object *obj = NULL;
-
-  is_searching = 0;
-  do
-  {
-    obj = lookupObject(name);
-    if (obj != NULL && obj->kind == OBJ_FUNCTION)
-      break;
-  } while (obj != NULL);
+  Object *obj = lookupObjectOfKind(ctx, symbol, OBJ_FUNCTION);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_FUNCTION, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_FUNCTION, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredProcedure(char *name)
+Object *checkDeclaredProcedure(KplContext *ctx, int symbol)
 {
-  Object *obj = NULL;
-
-  is_searching = 0;
-  do
-  {
-    obj = lookupObject(name);
-    if (obj != NULL && obj->kind == OBJ_PROCEDURE)
-      break;
-  } while (obj != NULL);
+  Object *obj = lookupObjectOfKind(ctx, symbol, OBJ_PROCEDURE);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_PROCEDURE, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_PROCEDURE, ctx->currentToken.offset);
 
   return obj;
 }
 
-Object *checkDeclaredLValueIdent(char *name)
+Object *checkDeclaredLValueIdent(KplContext *ctx, int symbol)
 {
   Object *obj = NULL;
 
-  is_searching = 0;
+  beginLookup(ctx);
   do
   {
-    obj = lookupObject(name);
+    obj = lookupObject(ctx, symbol);
     if (obj != NULL &&
         (obj->kind == OBJ_FUNCTION ||
          obj->kind == OBJ_PARAMETER ||
@@ -159,7 +146,7 @@ Object *checkDeclaredLValueIdent(char *name)
   } while (obj != NULL);
 
   if (obj == NULL)
-    error(ERR_UNDECLARED_IDENT, currentToken->lineNo, currentToken->colNo);
+    error(ctx, ERR_UNDECLARED_IDENT, ctx->currentToken.offset);
 
   return obj;
 }
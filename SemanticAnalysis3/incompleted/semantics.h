@@ -9,13 +9,13 @@
 
 #include "symtab.h"
 
-void checkFreshIdent(char *name);
-Object* checkDeclaredIdent(char *name);
-Object* checkDeclaredConstant(char *name);
-Object* checkDeclaredType(char *name);
-Object* checkDeclaredVariable(char *name);
-Object* checkDeclaredFunction(char *name);
-Object* checkDeclaredProcedure(char *name);
-Object* checkDeclaredLValueIdent(char *name);
+void checkFreshIdent(KplContext *ctx, int symbol);
+Object* checkDeclaredIdent(KplContext *ctx, int symbol);
+Object* checkDeclaredConstant(KplContext *ctx, int symbol);
+Object* checkDeclaredType(KplContext *ctx, int symbol);
+Object* checkDeclaredVariable(KplContext *ctx, int symbol);
+Object* checkDeclaredFunction(KplContext *ctx, int symbol);
+Object* checkDeclaredProcedure(KplContext *ctx, int symbol);
+Object* checkDeclaredLValueIdent(KplContext *ctx, int symbol);
 
 #endif
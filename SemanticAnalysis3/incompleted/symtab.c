@@ -9,16 +9,13 @@
 #include <string.h>
 #include "symtab.h"
 #include "error.h"
+#include "interner.h"
 
 void freeObject(Object* obj);
 void freeScope(Scope* scope);
 void freeObjectList(ObjectNode *objList);
 void freeReferenceList(ObjectNode *objList);
 
-SymTab* symtab;
-Type* intType;
-Type* charType;
-
 /******************* Type utilities ******************************/
 
 Type* makeIntType(void) {
@@ -110,66 +107,107 @@ Scope* createScope(Object* owner, Scope* outer) {
   return scope;
 }
 
-Object* createProgramObject(char *programName) {
+// Gives obj the next index of the object table
+void numberObject(KplContext *ctx, Object *obj) {
+  SymTab *symtab = ctx->symtab;
+
+  if (symtab->objectCount == symtab->objectCapacity) {
+    symtab->objectCapacity = (symtab->objectCapacity == 0) ? 64 : 2 * symtab->objectCapacity;
+    symtab->objects = (Object**) realloc(symtab->objects, symtab->objectCapacity * sizeof(Object*));
+  }
+  obj->index = symtab->objectBase + symtab->objectCount;
+  symtab->objects[symtab->objectCount ++] = obj;
+}
+
+Object* createProgramObject(KplContext *ctx, int symbol) {
   Object* program = (Object*) malloc(sizeof(Object));
-  strcpy(program->name, programName);
+  program->symbol = symbol;
+  program->name = symbolName(ctx->interner, symbol);
   program->kind = OBJ_PROGRAM;
+  numberObject(ctx, program);
   program->progAttrs = (ProgramAttributes*) malloc(sizeof(ProgramAttributes));
   program->progAttrs->scope = createScope(program,NULL);
-  symtab->program = program;
+  program->progAttrs->body = NO_NODE;
+  program->progAttrs->bodyOffset = 0;
+  ctx->symtab->program = program;
 
   return program;
 }
 
-Object* createConstantObject(char *name) {
+Object* createConstantObject(KplContext *ctx, int symbol) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_CONSTANT;
+  numberObject(ctx, obj);
   obj->constAttrs = (ConstantAttributes*) malloc(sizeof(ConstantAttributes));
   return obj;
 }
 
-Object* createTypeObject(char *name) {
+Object* createTypeObject(KplContext *ctx, int symbol) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_TYPE;
+  numberObject(ctx, obj);
   obj->typeAttrs = (TypeAttributes*) malloc(sizeof(TypeAttributes));
   return obj;
 }
 
-Object* createVariableObject(char *name) {
+Object* createVariableObject(KplContext *ctx, int symbol) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_VARIABLE;
+  numberObject(ctx, obj);
   obj->varAttrs = (VariableAttributes*) malloc(sizeof(VariableAttributes));
-  obj->varAttrs->scope = symtab->currentScope;
+  obj->varAttrs->scope = ctx->symtab->currentScope;
   return obj;
 }
 
-Object* createFunctionObject(char *name) {
+Object* createFunctionObject(KplContext *ctx, int symbol) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_FUNCTION;
+  numberObject(ctx, obj);
   obj->funcAttrs = (FunctionAttributes*) malloc(sizeof(FunctionAttributes));
   obj->funcAttrs->paramList = NULL;
-  obj->funcAttrs->scope = createScope(obj, symtab->currentScope);
+  obj->funcAttrs->returnType = NULL;
+  obj->funcAttrs->scope = createScope(obj, ctx->symtab->currentScope);
+  obj->funcAttrs->body = NO_NODE;
+  obj->funcAttrs->bodyOffset = 0;
+  obj->funcAttrs->firstToken = -1;
+  obj->funcAttrs->lastToken = -1;
+  obj->funcAttrs->bodyToken = -1;
+  obj->funcAttrs->pending = 0;
   return obj;
 }
 
-Object* createProcedureObject(char *name) {
+Object* createProcedureObject(KplContext *ctx, int symbol) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_PROCEDURE;
+  numberObject(ctx, obj);
   obj->procAttrs = (ProcedureAttributes*) malloc(sizeof(ProcedureAttributes));
   obj->procAttrs->paramList = NULL;
-  obj->procAttrs->scope = createScope(obj, symtab->currentScope);
+  obj->procAttrs->scope = createScope(obj, ctx->symtab->currentScope);
+  obj->procAttrs->body = NO_NODE;
+  obj->procAttrs->bodyOffset = 0;
+  obj->procAttrs->firstToken = -1;
+  obj->procAttrs->lastToken = -1;
+  obj->procAttrs->bodyToken = -1;
+  obj->procAttrs->pending = 0;
   return obj;
 }
 
-Object* createParameterObject(char *name, enum ParamKind kind, Object* owner) {
+Object* createParameterObject(KplContext *ctx, int symbol, enum ParamKind kind, Object* owner) {
   Object* obj = (Object*) malloc(sizeof(Object));
-  strcpy(obj->name, name);
+  obj->symbol = symbol;
+  obj->name = symbolName(ctx->interner, symbol);
   obj->kind = OBJ_PARAMETER;
+  numberObject(ctx, obj);
   obj->paramAttrs = (ParameterAttributes*) malloc(sizeof(ParameterAttributes));
   obj->paramAttrs->kind = kind;
   obj->paramAttrs->function = owner;
@@ -192,7 +230,8 @@ void freeObject(Object* obj) {
     break;
   case OBJ_FUNCTION:
     freeReferenceList(obj->funcAttrs->paramList);
-    freeType(obj->funcAttrs->returnType);
+    if (obj->funcAttrs->returnType != NULL)
+      freeType(obj->funcAttrs->returnType);
     freeScope(obj->funcAttrs->scope);
     free(obj->funcAttrs);
     break;
@@ -252,10 +291,23 @@ void addObject(ObjectNode **objList, Object* obj) {
   }
 }
 
-Object* findObject(ObjectNode *objList, char *name) {
+Object* findObject(ObjectNode *objList, int symbol) {
+  while (objList != NULL) {
+    if (objList->object->symbol == symbol)
+      return objList->object;
+    else objList = objList->next;
+  }
+  return NULL;
+}
+
+// Like findObject, but the objects after last, if it is not NULL, are
+// not seen
+Object* findObjectUpTo(ObjectNode *objList, int symbol, Object *last) {
   while (objList != NULL) {
-    if (strcmp(objList->object->name, name) == 0) 
+    if (objList->object->symbol == symbol)
       return objList->object;
+    else if (objList->object == last)
+      return NULL;
     else objList = objList->next;
   }
   return NULL;
@@ -263,59 +315,71 @@ Object* findObject(ObjectNode *objList, char *name) {
 
 /******************* others ******************************/
 
-void initSymTab(void) {
+int builtinSymbol(KplContext *ctx, char *name) {
+  return internName(ctx->interner, name, strlen(name));
+}
+
+void initSymTab(KplContext *ctx) {
   Object* obj;
   Object* param;
 
-  symtab = (SymTab*) malloc(sizeof(SymTab));
-  symtab->globalObjectList = NULL;
+  ctx->symtab = (SymTab*) malloc(sizeof(SymTab));
+  ctx->symtab->program = NULL;
+  ctx->symtab->currentScope = NULL;
+  ctx->symtab->globalObjectList = NULL;
+  ctx->symtab->objects = NULL;
+  ctx->symtab->objectCount = 0;
+  ctx->symtab->objectCapacity = 0;
+  ctx->symtab->objectBase = 0;
   
-  obj = createFunctionObject("READC");
+  obj = createFunctionObject(ctx, builtinSymbol(ctx, "READC"));
   obj->funcAttrs->returnType = makeCharType();
-  addObject(&(symtab->globalObjectList), obj);
+  addObject(&(ctx->symtab->globalObjectList), obj);
 
-  obj = createFunctionObject("READI");
+  obj = createFunctionObject(ctx, builtinSymbol(ctx, "READI"));
   obj->funcAttrs->returnType = makeIntType();
-  addObject(&(symtab->globalObjectList), obj);
+  addObject(&(ctx->symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITEI");
-  param = createParameterObject("i", PARAM_VALUE, obj);
+  obj = createProcedureObject(ctx, builtinSymbol(ctx, "WRITEI"));
+  param = createParameterObject(ctx, builtinSymbol(ctx, "i"), PARAM_VALUE, obj);
   param->paramAttrs->type = makeIntType();
   addObject(&(obj->procAttrs->paramList),param);
-  addObject(&(symtab->globalObjectList), obj);
+  addObject(&(ctx->symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITEC");
-  param = createParameterObject("ch", PARAM_VALUE, obj);
+  obj = createProcedureObject(ctx, builtinSymbol(ctx, "WRITEC"));
+  param = createParameterObject(ctx, builtinSymbol(ctx, "ch"), PARAM_VALUE, obj);
   param->paramAttrs->type = makeCharType();
   addObject(&(obj->procAttrs->paramList),param);
-  addObject(&(symtab->globalObjectList), obj);
+  addObject(&(ctx->symtab->globalObjectList), obj);
 
-  obj = createProcedureObject("WRITELN");
-  addObject(&(symtab->globalObjectList), obj);
+  obj = createProcedureObject(ctx, builtinSymbol(ctx, "WRITELN"));
+  addObject(&(ctx->symtab->globalObjectList), obj);
 
-  intType = makeIntType();
-  charType = makeCharType();
+  ctx->intType = makeIntType();
+  ctx->charType = makeCharType();
 }
 
-void cleanSymTab(void) {
-  freeObject(symtab->program);
-  freeObjectList(symtab->globalObjectList);
-  free(symtab);
-  freeType(intType);
-  freeType(charType);
+void cleanSymTab(KplContext *ctx) {
+  if (ctx->symtab->program != NULL)
+    freeObject(ctx->symtab->program);
+  freeObjectList(ctx->symtab->globalObjectList);
+  free(ctx->symtab->objects);
+  free(ctx->symtab);
+  freeType(ctx->intType);
+  freeType(ctx->charType);
 }
 
-void enterBlock(Scope* scope) {
-  symtab->currentScope = scope;
+void enterBlock(KplContext *ctx, Scope* scope) {
+  ctx->symtab->currentScope = scope;
 }
 
-void exitBlock(void) {
-  symtab->currentScope = symtab->currentScope->outer;
+void exitBlock(KplContext *ctx) {
+  ctx->symtab->currentScope = ctx->symtab->currentScope->outer;
 }
 
-void declareObject(Object* obj) {
+void declareObject(KplContext *ctx, Object* obj) {
   if (obj->kind == OBJ_PARAMETER) {
-    Object* owner = symtab->currentScope->owner;
+    Object* owner = ctx->symtab->currentScope->owner;
     switch (owner->kind) {
     case OBJ_FUNCTION:
       addObject(&(owner->funcAttrs->paramList), obj);
@@ -328,7 +392,7 @@ void declareObject(Object* obj) {
     }
   }
  
-  addObject(&(symtab->currentScope->objList), obj);
+  addObject(&(ctx->symtab->currentScope->objList), obj);
 }
 
 
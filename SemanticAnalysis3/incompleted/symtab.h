@@ -7,7 +7,9 @@
 #ifndef __SYMTAB_H__
 #define __SYMTAB_H__
 
+#include "context.h"
 #include "token.h"
+#include "ast.h"
 
 enum TypeClass {
   TP_INT,
@@ -67,19 +69,37 @@ struct TypeAttributes_ {
   Type *actualType;
 };
 
+// body is the statement part in the tree of the parser, NO_NODE for the
+// built-in subprograms, and bodyOffset where it starts in the source, the
+// offset its nodes are from. With pretokenized input, the block is the
+// tokens from firstToken to lastToken, -1 otherwise. pending is set while
+// the statement part, from the token at bodyToken on, is left for later,
+// in lazy mode.
 struct ProcedureAttributes_ {
   struct ObjectNode_ *paramList;
   struct Scope_* scope;
+  NodeId body;
+  int bodyOffset;
+  int firstToken, lastToken;
+  int bodyToken;
+  int pending;
 };
 
 struct FunctionAttributes_ {
   struct ObjectNode_ *paramList;
   Type* returnType;
   struct Scope_ *scope;
+  NodeId body;
+  int bodyOffset;
+  int firstToken, lastToken;
+  int bodyToken;
+  int pending;
 };
 
 struct ProgramAttributes_ {
   struct Scope_ *scope;
+  NodeId body;
+  int bodyOffset;
 };
 
 struct ParameterAttributes_ {
@@ -96,8 +116,12 @@ typedef struct ProcedureAttributes_ ProcedureAttributes;
 typedef struct ProgramAttributes_ ProgramAttributes;
 typedef struct ParameterAttributes_ ParameterAttributes;
 
+// name is the spelling of symbol, owned by the interner. index is the
+// place of the object in the object table.
 struct Object_ {
-  char name[MAX_IDENT_LEN];
+  int symbol;
+  int index;
+  char *name;
   enum ObjectKind kind;
   union {
     ConstantAttributes* constAttrs;
@@ -127,14 +151,25 @@ struct Scope_ {
 
 typedef struct Scope_ Scope;
 
+// objects holds every object created, by index, for the tree of the
+// parser to refer to them with 32 bits. The table of a subprogram body
+// parsed on its own holds only the objects of the body, numbered from
+// objectBase on; they get their final index when the body joins the
+// program.
 struct SymTab_ {
   Object* program;
   Scope* currentScope;
   ObjectNode *globalObjectList;
+  Object **objects;
+  int objectCount;
+  int objectCapacity;
+  int objectBase;
 };
 
 typedef struct SymTab_ SymTab;
 
+#define OBJECT(symtab, index) ((symtab)->objects[index])
+
 Type* makeIntType(void);
 Type* makeCharType(void);
 Type* makeArrayType(int arraySize, Type* elementType);
@@ -148,20 +183,23 @@ ConstantValue* duplicateConstantValue(ConstantValue* v);
 
 Scope* createScope(Object* owner, Scope* outer);
 
-Object* createProgramObject(char *programName);
-Object* createConstantObject(char *name);
-Object* createTypeObject(char *name);
-Object* createVariableObject(char *name);
-Object* createFunctionObject(char *name);
-Object* createProcedureObject(char *name);
-Object* createParameterObject(char *name, enum ParamKind kind, Object* owner);
-
-Object* findObject(ObjectNode *objList, char *name);
-
-void initSymTab(void);
-void cleanSymTab(void);
-void enterBlock(Scope* scope);
-void exitBlock(void);
-void declareObject(Object* obj);
+Object* createProgramObject(KplContext *ctx, int symbol);
+Object* createConstantObject(KplContext *ctx, int symbol);
+Object* createTypeObject(KplContext *ctx, int symbol);
+Object* createVariableObject(KplContext *ctx, int symbol);
+Object* createFunctionObject(KplContext *ctx, int symbol);
+Object* createProcedureObject(KplContext *ctx, int symbol);
+Object* createParameterObject(KplContext *ctx, int symbol, enum ParamKind kind, Object* owner);
+
+void numberObject(KplContext *ctx, Object *obj);
+void freeObjectList(ObjectNode *objList);
+Object* findObject(ObjectNode *objList, int symbol);
+Object* findObjectUpTo(ObjectNode *objList, int symbol, Object *last);
+
+void initSymTab(KplContext *ctx);
+void cleanSymTab(KplContext *ctx);
+void enterBlock(KplContext *ctx, Scope* scope);
+void exitBlock(KplContext *ctx);
+void declareObject(KplContext *ctx, Object* obj);
 
 #endif
@@ -0,0 +1,650 @@
+/* Table-driven parser
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+// An alternative to the recursive descent of parser.c: an LL(1) parser
+// driven by the table that gramgen makes out of kpl.grammar, see
+// gramtable.h. The symbols still to be matched are kept on a stack of
+// their own, so how deep statements nest is bounded by memory, not by
+// the C stack. The semantic actions of the grammar work on a second stack
+// holding the nodes, objects, types and constants parsed so far, and
+// call the symbol table and the semantic checks in the very order the
+// recursive descent parser does: the trees and objects are the same, up
+// to their indexes.
+//
+// The table parser does not recover from errors. At the first one,
+// lexical, syntactic or semantic, the program is parsed again by
+// recursive descent, whose diagnostics are the ones reported.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tokenbuffer.h"
+#include "parser.h"
+#include "semantics.h"
+#include "error.h"
+#include "tableparser.h"
+#include "gramtable.h"
+
+// What the actions leave for each other
+union SemanticValue {
+  int number;
+  NodeId node;
+  Object *object;
+  Type *type;
+  ConstantValue *value;
+};
+
+struct ValueStack {
+  union SemanticValue *values;
+  int count;
+  int capacity;
+};
+
+// The grammar symbols still to be matched, the next one on top
+struct SymbolStack {
+  unsigned char *symbols;
+  int count;
+  int capacity;
+};
+
+#define INITIAL_STACK 256
+
+#define POP(stack) ((stack)->values[-- (stack)->count])
+// depth 0 is the top
+#define TOP(stack, depth) ((stack)->values[(stack)->count - 1 - (depth)])
+
+union SemanticValue *push(struct ValueStack *stack) {
+  if (stack->count == stack->capacity) {
+    stack->capacity = (stack->capacity == 0) ? INITIAL_STACK : 2 * stack->capacity;
+    stack->values = (union SemanticValue*) realloc(stack->values, stack->capacity * sizeof(union SemanticValue));
+  }
+  return &stack->values[stack->count ++];
+}
+
+// What is wrong, the recursive descent parser tells
+void syntaxError(KplContext *ctx) {
+  longjmp(ctx->errorJump, 1);
+}
+
+/******************************************************************/
+// Program and blocks
+
+void actionProgram(KplContext *ctx, struct ValueStack *stack) {
+  Object *program = createProgramObject(ctx, ctx->currentToken.value);
+
+  enterBlock(ctx, program->progAttrs->scope);
+  push(stack)->object = program;
+}
+
+void actionProgramBody(KplContext *ctx, struct ValueStack *stack) {
+  NodeId body = POP(stack).node;
+  Object *program = POP(stack).object;
+
+  program->progAttrs->body = body;
+  program->progAttrs->bodyOffset = ctx->ast->base;
+  exitBlock(ctx);
+}
+
+// The nodes of a statement part are placed from its BEGIN, as in
+// compileBlock5()
+void actionStatementPart(KplContext *ctx, struct ValueStack *stack) {
+  ctx->ast->base = ctx->lookAhead.offset;
+  push(stack)->number = ctx->lookAhead.offset;
+}
+
+// Where the statement about to be parsed starts
+void actionStart(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->lookAhead.offset;
+}
+
+void actionGroup(KplContext *ctx, struct ValueStack *stack) {
+  int statements, offset;
+
+  // The last statement of the list
+  stack->count --;
+  statements = POP(stack).number;
+  offset = POP(stack).number;
+  push(stack)->node = newNode(ctx->ast, N_GROUP, offset, statements, 0);
+}
+
+// A list is built as its head and its last entry
+void actionList(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = NO_LIST;
+  push(stack)->number = NO_LIST;
+}
+
+void actionAppend(KplContext *ctx, struct ValueStack *stack) {
+  NodeId node = POP(stack).node;
+
+  appendNode(ctx->ast, &TOP(stack, 1).number, &TOP(stack, 0).number, node);
+}
+
+/******************************************************************/
+// Declarations
+
+void actionNewConstant(KplContext *ctx, struct ValueStack *stack) {
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  push(stack)->object = createConstantObject(ctx, ctx->currentToken.value);
+}
+
+void actionDeclareConstant(KplContext *ctx, struct ValueStack *stack) {
+  ConstantValue *value = POP(stack).value;
+  Object *constObj = POP(stack).object;
+
+  constObj->constAttrs->value = value;
+  declareObject(ctx, constObj);
+}
+
+void actionNewType(KplContext *ctx, struct ValueStack *stack) {
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  push(stack)->object = createTypeObject(ctx, ctx->currentToken.value);
+}
+
+void actionDeclareType(KplContext *ctx, struct ValueStack *stack) {
+  Type *actualType = POP(stack).type;
+  Object *typeObj = POP(stack).object;
+
+  typeObj->typeAttrs->actualType = actualType;
+  declareObject(ctx, typeObj);
+}
+
+void actionNewVariable(KplContext *ctx, struct ValueStack *stack) {
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  push(stack)->object = createVariableObject(ctx, ctx->currentToken.value);
+}
+
+void actionDeclareVariable(KplContext *ctx, struct ValueStack *stack) {
+  Type *varType = POP(stack).type;
+  Object *varObj = POP(stack).object;
+
+  varObj->varAttrs->type = varType;
+  declareObject(ctx, varObj);
+}
+
+void actionNewFunction(KplContext *ctx, struct ValueStack *stack) {
+  Object *funcObj;
+
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  funcObj = createFunctionObject(ctx, ctx->currentToken.value);
+  declareObject(ctx, funcObj);
+  enterBlock(ctx, funcObj->funcAttrs->scope);
+  push(stack)->object = funcObj;
+}
+
+void actionReturnType(KplContext *ctx, struct ValueStack *stack) {
+  Type *returnType = POP(stack).type;
+
+  TOP(stack, 0).object->funcAttrs->returnType = returnType;
+}
+
+void actionNewProcedure(KplContext *ctx, struct ValueStack *stack) {
+  Object *procObj;
+
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  procObj = createProcedureObject(ctx, ctx->currentToken.value);
+  declareObject(ctx, procObj);
+  enterBlock(ctx, procObj->procAttrs->scope);
+  push(stack)->object = procObj;
+}
+
+// The token range of the block, as compileSubprogramBlock() keeps it
+void actionSubprogramBlock(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->tokenIndex - 1;
+}
+
+void actionSubprogramBody(KplContext *ctx, struct ValueStack *stack) {
+  NodeId body = POP(stack).node;
+  int first = POP(stack).number;
+  Object *owner = TOP(stack, 0).object;
+
+  if (owner->kind == OBJ_FUNCTION) {
+    owner->funcAttrs->body = body;
+    owner->funcAttrs->bodyOffset = ctx->ast->base;
+    owner->funcAttrs->firstToken = first;
+    owner->funcAttrs->lastToken = ctx->tokenIndex - 2;
+  } else {
+    owner->procAttrs->body = body;
+    owner->procAttrs->bodyOffset = ctx->ast->base;
+    owner->procAttrs->firstToken = first;
+    owner->procAttrs->lastToken = ctx->tokenIndex - 2;
+  }
+}
+
+void actionExitBlock(KplContext *ctx, struct ValueStack *stack) {
+  stack->count --;
+  exitBlock(ctx);
+}
+
+void actionValueParam(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = PARAM_VALUE;
+}
+
+void actionReferenceParam(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = PARAM_REFERENCE;
+}
+
+void actionNewParam(KplContext *ctx, struct ValueStack *stack) {
+  enum ParamKind paramKind = POP(stack).number;
+
+  checkFreshIdent(ctx, ctx->currentToken.value);
+  push(stack)->object = createParameterObject(ctx, ctx->currentToken.value, paramKind, ctx->symtab->currentScope->owner);
+}
+
+void actionDeclareParam(KplContext *ctx, struct ValueStack *stack) {
+  Type *type = POP(stack).type;
+  Object *param = POP(stack).object;
+
+  param->paramAttrs->type = type;
+  declareObject(ctx, param);
+}
+
+/******************************************************************/
+// Constants and types
+
+void actionNumberConstant(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->value = makeIntConstant(ctx->currentToken.value);
+}
+
+void actionCharConstant(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->value = makeCharConstant(ctx->currentToken.value);
+}
+
+void actionNamedConstant(KplContext *ctx, struct ValueStack *stack) {
+  Object *obj = checkDeclaredConstant(ctx, ctx->currentToken.value);
+
+  push(stack)->value = duplicateConstantValue(obj->constAttrs->value);
+}
+
+void actionNegateConstant(KplContext *ctx, struct ValueStack *stack) {
+  TOP(stack, 0).value->intValue = -TOP(stack, 0).value->intValue;
+}
+
+void actionIntType(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->type = makeIntType();
+}
+
+void actionCharType(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->type = makeCharType();
+}
+
+void actionArraySize(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->currentToken.value;
+}
+
+void actionArrayType(KplContext *ctx, struct ValueStack *stack) {
+  Type *elementType = POP(stack).type;
+  int arraySize = POP(stack).number;
+
+  push(stack)->type = makeArrayType(arraySize, elementType);
+}
+
+void actionNamedType(KplContext *ctx, struct ValueStack *stack) {
+  Object *obj = checkDeclaredType(ctx, ctx->currentToken.value);
+
+  push(stack)->type = duplicateType(obj->typeAttrs->actualType);
+}
+
+/******************************************************************/
+// Statements
+
+void actionEmptySt(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->node = NO_NODE;
+}
+
+void actionLValue(KplContext *ctx, struct ValueStack *stack) {
+  Object *var = checkDeclaredLValueIdent(ctx, ctx->currentToken.value);
+
+  // Only a variable is indexed
+  if ((ctx->lookAhead.tokenType == SB_LSEL) && (var->kind != OBJ_VARIABLE))
+    syntaxError(ctx);
+
+  switch (var->kind) {
+  case OBJ_VARIABLE:
+    push(stack)->node = objectNode(ctx, N_VARIABLE, var, 0);
+    break;
+  case OBJ_PARAMETER:
+    push(stack)->node = objectNode(ctx, N_PARAMETER, var, 0);
+    break;
+  default:
+    push(stack)->node = objectNode(ctx, N_FUNCTION, var, NO_LIST);
+    break;
+  }
+}
+
+void actionAssign(KplContext *ctx, struct ValueStack *stack) {
+  NodeId expression = POP(stack).node;
+  NodeId lvalue = POP(stack).node;
+  int offset = POP(stack).number;
+
+  push(stack)->node = newNode(ctx->ast, N_ASSIGN, offset, lvalue, expression);
+}
+
+// The procedure and its arguments, none until Arguments says otherwise
+void actionProcedure(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->object = checkDeclaredProcedure(ctx, ctx->currentToken.value);
+  push(stack)->number = NO_LIST;
+}
+
+void actionCall(KplContext *ctx, struct ValueStack *stack) {
+  int arguments = POP(stack).number;
+  Object *proc = POP(stack).object;
+  int offset = POP(stack).number;
+
+  push(stack)->node = newNode(ctx->ast, N_CALL, offset, proc->index, arguments);
+}
+
+// The branches are allocated before the condition, as by compileIfSt()
+void actionBeginIf(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->lookAhead.offset;
+  push(stack)->number = newExtra(ctx->ast, 2);
+}
+
+void actionThen(KplContext *ctx, struct ValueStack *stack) {
+  NodeId thenPart = POP(stack).node;
+  int branches = TOP(stack, 1).number;
+
+  ctx->ast->extra[branches] = thenPart;
+  ctx->ast->extra[branches + 1] = NO_NODE;
+}
+
+void actionElse(KplContext *ctx, struct ValueStack *stack) {
+  NodeId elsePart = POP(stack).node;
+
+  ctx->ast->extra[TOP(stack, 1).number + 1] = elsePart;
+}
+
+void actionEndIf(KplContext *ctx, struct ValueStack *stack) {
+  NodeId condition = POP(stack).node;
+  int branches = POP(stack).number;
+  int offset = POP(stack).number;
+
+  push(stack)->node = newNode(ctx->ast, N_IF, offset, condition, branches);
+}
+
+void actionWhile(KplContext *ctx, struct ValueStack *stack) {
+  NodeId body = POP(stack).node;
+  NodeId condition = POP(stack).node;
+  int offset = POP(stack).number;
+
+  push(stack)->node = newNode(ctx->ast, N_WHILE, offset, condition, body);
+}
+
+void actionBeginFor(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->lookAhead.offset;
+  push(stack)->number = newExtra(ctx->ast, 3);
+}
+
+void actionForVariable(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->object = checkDeclaredVariable(ctx, ctx->currentToken.value);
+}
+
+void actionEndFor(KplContext *ctx, struct ValueStack *stack) {
+  NodeId body = POP(stack).node;
+  NodeId to = POP(stack).node;
+  NodeId from = POP(stack).node;
+  Object *var = POP(stack).object;
+  int parts = POP(stack).number;
+  int offset = POP(stack).number;
+
+  ctx->ast->extra[parts] = from;
+  ctx->ast->extra[parts + 1] = to;
+  ctx->ast->extra[parts + 2] = body;
+  push(stack)->node = newNode(ctx->ast, N_FOR, offset, var->index, parts);
+}
+
+/******************************************************************/
+// Expressions
+
+// Replaces the empty argument list under the list being built
+void actionArguments(KplContext *ctx, struct ValueStack *stack) {
+  int list;
+
+  // The last argument of the list
+  stack->count --;
+  list = POP(stack).number;
+  TOP(stack, 0).number = list;
+}
+
+void actionOperator(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = ctx->currentToken.tokenType;
+}
+
+void actionCondition(KplContext *ctx, struct ValueStack *stack) {
+  NodeId right = POP(stack).node;
+  TokenType op = POP(stack).number;
+  NodeId left = POP(stack).node;
+
+  push(stack)->node = operatorNode(ctx, N_CONDITION, op, left, right);
+}
+
+void actionBinary(KplContext *ctx, struct ValueStack *stack) {
+  NodeId right = POP(stack).node;
+  TokenType op = POP(stack).number;
+  NodeId left = POP(stack).node;
+
+  push(stack)->node = operatorNode(ctx, N_BINARY, op, left, right);
+}
+
+// Where the leading minus of an expression is, -1 without one
+void actionUnsigned(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->number = -1;
+}
+
+void actionNegative(KplContext *ctx, struct ValueStack *stack) {
+  TOP(stack, 0).number = ctx->currentToken.offset;
+}
+
+void actionSign(KplContext *ctx, struct ValueStack *stack) {
+  NodeId term = POP(stack).node;
+  int minus = POP(stack).number;
+
+  push(stack)->node = (minus < 0) ? term : newNode(ctx->ast, N_NEGATE, minus, term, 0);
+}
+
+void actionNumber(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->node = tokenNode(ctx, N_NUMBER);
+}
+
+void actionChar(KplContext *ctx, struct ValueStack *stack) {
+  push(stack)->node = tokenNode(ctx, N_CHAR);
+}
+
+// Leaves where the identifier is, its object and either its node or,
+// for a function, its argument list
+void actionIdentifier(KplContext *ctx, struct ValueStack *stack) {
+  Object *obj = checkDeclaredIdent(ctx, ctx->currentToken.value);
+
+  switch (obj->kind) {
+  case OBJ_CONSTANT:
+  case OBJ_VARIABLE:
+  case OBJ_PARAMETER:
+  case OBJ_FUNCTION:
+    break;
+  default:
+    error(ctx, ERR_INVALID_FACTOR, ctx->currentToken.offset);
+  }
+
+  // Only a variable is indexed and only a function takes arguments
+  if (((ctx->lookAhead.tokenType == SB_LSEL) && (obj->kind != OBJ_VARIABLE)) ||
+      ((ctx->lookAhead.tokenType == SB_LPAR) && (obj->kind != OBJ_FUNCTION)))
+    syntaxError(ctx);
+
+  push(stack)->number = ctx->currentToken.offset;
+  push(stack)->object = obj;
+  switch (obj->kind) {
+  case OBJ_CONSTANT:
+    push(stack)->node = objectNode(ctx, N_CONSTANT, obj, 0);
+    break;
+  case OBJ_VARIABLE:
+    push(stack)->node = objectNode(ctx, N_VARIABLE, obj, 0);
+    break;
+  case OBJ_PARAMETER:
+    push(stack)->node = objectNode(ctx, N_PARAMETER, obj, 0);
+    break;
+  default:
+    push(stack)->number = NO_LIST;
+    break;
+  }
+}
+
+void actionFactor(KplContext *ctx, struct ValueStack *stack) {
+  union SemanticValue top = POP(stack);
+  Object *obj = POP(stack).object;
+  int offset = POP(stack).number;
+
+  if (obj->kind == OBJ_FUNCTION)
+    push(stack)->node = newNode(ctx->ast, N_FUNCTION, offset, obj->index, top.number);
+  else push(stack)->node = top.node;
+}
+
+void actionIndex(KplContext *ctx, struct ValueStack *stack) {
+  NodeId index = POP(stack).node;
+  NodeId base = TOP(stack, 0).node;
+
+  TOP(stack, 0).node = newNode(ctx->ast, N_INDEX, SOURCE_OFFSET(ctx->ast, base), base, index);
+}
+
+/******************************************************************/
+
+typedef void (*SemanticAction)(KplContext *ctx, struct ValueStack *stack);
+
+SemanticAction actions[ACTION_COUNT] = {
+  [ACTION_PROGRAM] = actionProgram,
+  [ACTION_PROGRAM_BODY] = actionProgramBody,
+  [ACTION_STATEMENT_PART] = actionStatementPart,
+  [ACTION_GROUP] = actionGroup,
+  [ACTION_NEW_CONSTANT] = actionNewConstant,
+  [ACTION_DECLARE_CONSTANT] = actionDeclareConstant,
+  [ACTION_NEW_TYPE] = actionNewType,
+  [ACTION_DECLARE_TYPE] = actionDeclareType,
+  [ACTION_NEW_VARIABLE] = actionNewVariable,
+  [ACTION_DECLARE_VARIABLE] = actionDeclareVariable,
+  [ACTION_NEW_FUNCTION] = actionNewFunction,
+  [ACTION_RETURN_TYPE] = actionReturnType,
+  [ACTION_SUBPROGRAM_BLOCK] = actionSubprogramBlock,
+  [ACTION_SUBPROGRAM_BODY] = actionSubprogramBody,
+  [ACTION_EXIT_BLOCK] = actionExitBlock,
+  [ACTION_NEW_PROCEDURE] = actionNewProcedure,
+  [ACTION_REFERENCE_PARAM] = actionReferenceParam,
+  [ACTION_VALUE_PARAM] = actionValueParam,
+  [ACTION_NEW_PARAM] = actionNewParam,
+  [ACTION_DECLARE_PARAM] = actionDeclareParam,
+  [ACTION_NEGATE_CONSTANT] = actionNegateConstant,
+  [ACTION_CHAR_CONSTANT] = actionCharConstant,
+  [ACTION_NUMBER_CONSTANT] = actionNumberConstant,
+  [ACTION_NAMED_CONSTANT] = actionNamedConstant,
+  [ACTION_INT_TYPE] = actionIntType,
+  [ACTION_CHAR_TYPE] = actionCharType,
+  [ACTION_ARRAY_SIZE] = actionArraySize,
+  [ACTION_ARRAY_TYPE] = actionArrayType,
+  [ACTION_NAMED_TYPE] = actionNamedType,
+  [ACTION_LIST] = actionList,
+  [ACTION_APPEND] = actionAppend,
+  [ACTION_EMPTY_ST] = actionEmptySt,
+  [ACTION_START] = actionStart,
+  [ACTION_ASSIGN] = actionAssign,
+  [ACTION_LVALUE] = actionLValue,
+  [ACTION_PROCEDURE] = actionProcedure,
+  [ACTION_CALL] = actionCall,
+  [ACTION_BEGIN_IF] = actionBeginIf,
+  [ACTION_THEN] = actionThen,
+  [ACTION_ELSE] = actionElse,
+  [ACTION_END_IF] = actionEndIf,
+  [ACTION_WHILE] = actionWhile,
+  [ACTION_BEGIN_FOR] = actionBeginFor,
+  [ACTION_FOR_VARIABLE] = actionForVariable,
+  [ACTION_END_FOR] = actionEndFor,
+  [ACTION_ARGUMENTS] = actionArguments,
+  [ACTION_OPERATOR] = actionOperator,
+  [ACTION_CONDITION] = actionCondition,
+  [ACTION_UNSIGNED] = actionUnsigned,
+  [ACTION_NEGATIVE] = actionNegative,
+  [ACTION_SIGN] = actionSign,
+  [ACTION_BINARY] = actionBinary,
+  [ACTION_NUMBER] = actionNumber,
+  [ACTION_CHAR] = actionChar,
+  [ACTION_IDENTIFIER] = actionIdentifier,
+  [ACTION_FACTOR] = actionFactor,
+  [ACTION_INDEX] = actionIndex
+};
+
+// Expands the nonterminal on top of symbols by the production the table
+// gives for the lookahead: its symbols go on the stack, the first one on
+// top
+void expand(KplContext *ctx, struct SymbolStack *symbols, int nonterminal) {
+  int production = parseTable[nonterminal - FIRST_NONTERMINAL][ctx->lookAhead.tokenType];
+  int start, length, i;
+
+  if (production == 0)
+    syntaxError(ctx);
+  production --;
+  start = productionStart[production];
+  length = productionStart[production + 1] - start;
+
+  if (symbols->count + length > symbols->capacity) {
+    symbols->capacity = 2 * (symbols->count + length);
+    symbols->symbols = (unsigned char*) realloc(symbols->symbols, symbols->capacity);
+  }
+  for (i = length - 1; i >= 0; i--)
+    symbols->symbols[symbols->count ++] = productionSymbols[start + i];
+}
+
+// Returns 1 when the program has been parsed up to its final period;
+// what comes after it is not looked at, as by compileProgram(). In
+// syntax-only mode the actions are skipped: the grammar alone is checked.
+int parseWithTable(KplContext *ctx, struct SymbolStack *symbols, struct ValueStack *values) {
+  int symbol;
+
+  if (setjmp(ctx->errorJump) != 0)
+    return 0;
+
+  scan(ctx);
+  symbols->count = 0;
+  expand(ctx, symbols, FIRST_NONTERMINAL);
+  while (symbols->count > 0) {
+    symbol = symbols->symbols[-- symbols->count];
+    if (symbol < FIRST_NONTERMINAL) {
+      if (ctx->lookAhead.tokenType != symbol)
+	syntaxError(ctx);
+      scan(ctx);
+    } else if (symbol < FIRST_ACTION)
+      expand(ctx, symbols, symbol);
+    else if (!ctx->syntaxOnly)
+      actions[symbol - FIRST_ACTION](ctx, values);
+  }
+  return 1;
+}
+
+// Parses the pretokenized input of ctx into its tree and, unless only the
+// syntax is checked, a new symbol table. When the table parser fails,
+// all it made is thrown away and recursive descent starts over.
+void parseProgramTable(KplContext *ctx) {
+  struct SymbolStack symbols = {NULL, 0, 0};
+  struct ValueStack values = {NULL, 0, 0};
+  int parsed;
+
+  if (!ctx->syntaxOnly)
+    initSymTab(ctx);
+  ctx->recoveryJump = NULL;
+  ctx->diagnosticCount = 0;
+  ctx->parseIncomplete = 1;
+  parsed = parseWithTable(ctx, &symbols, &values);
+  free(symbols.symbols);
+  free(values.values);
+  if (parsed) {
+    ctx->parseIncomplete = 0;
+    return;
+  }
+
+  if (!ctx->syntaxOnly)
+    cleanSymTab(ctx);
+  freeAst(ctx->ast);
+  ctx->ast = ctx->syntaxOnly ? createScratchAst() : createAst(ctx->tokens->count);
+  ctx->tokenIndex = 0;
+  if (!ctx->syntaxOnly)
+    initSymTab(ctx);
+  parseProgram(ctx);
+}
@@ -0,0 +1,12 @@
+/* Table-driven parser
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+#ifndef __TABLEPARSER_H__
+#define __TABLEPARSER_H__
+#include "context.h"
+
+void parseProgramTable(KplContext *ctx);
+
+#endif
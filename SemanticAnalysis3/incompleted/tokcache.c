@@ -0,0 +1,185 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "reader.h"
+#include "tokcache.h"
+#include "interner.h"
+#include "error.h"
+
+// FNV-1a, 64 bits
+uint64_t hashSource(char *buffer, int size) {
+  uint64_t hash = 14695981039346656037ull;
+  int i;
+
+  for (i = 0; i < size; i++)
+    hash = (hash ^ (unsigned char) buffer[i]) * 1099511628211ull;
+  return hash;
+}
+
+int validHeader(KplContext *ctx, struct TokenCacheHeader *header, off_t fileSize) {
+  int sourceSize = ctx->inputEnd - ctx->inputBuffer;
+
+  if ((header->magic != TOKEN_CACHE_MAGIC) || (header->version != TOKEN_CACHE_VERSION))
+    return 0;
+  if (fileSize != (off_t) sizeof(struct TokenCacheHeader) +
+      (off_t) header->tokenCount * (3 * sizeof(int32_t) + sizeof(uint8_t)) + header->namesSize)
+    return 0;
+  if ((header->sourceSize != sourceSize) || (header->tokenCount == 0))
+    return 0;
+  return header->sourceHash == hashSource(ctx->inputBuffer, sourceSize);
+}
+
+// Symbol IDs are those of the interner that wrote the file; the names
+// are interned again here, and the identifiers renumbered unless the IDs
+// came out the same. Every entry is checked first, so that a file turned
+// down leaves nothing in the interner. The stream has to end with its
+// TK_EOF, or with the TK_NONE of a lexical error, and have neither
+// before: nextBufferedToken() reads no further.
+int loadSymbols(KplContext *ctx, TokenBuffer *tokens, char *names, int namesSize, int symbolCount) {
+  int sourceSize = ctx->inputEnd - ctx->inputBuffer;
+  int *symbols;
+  int renumber = 0, last;
+  char *name = names;
+  int i, length;
+
+  if (symbolCount > namesSize)
+    return 0;
+  for (i = 0; i < symbolCount; i++) {
+    length = strnlen(name, names + namesSize - name);
+    if (name + length == names + namesSize)
+      return 0;
+    name += length + 1;
+  }
+
+  for (i = 0; i < tokens->count; i++) {
+    if ((tokens->types[i] > SB_RSEL) || (tokens->offsets[i] < 0) || (tokens->lengths[i] < 0) ||
+	(tokens->offsets[i] > sourceSize - tokens->lengths[i]))
+      return 0;
+    last = (tokens->types[i] == TK_EOF) || (tokens->types[i] == TK_NONE);
+    if (last != (i == tokens->count - 1))
+      return 0;
+    if ((tokens->types[i] == TK_IDENT) && ((tokens->values[i] < 0) || (tokens->values[i] >= symbolCount)))
+      return 0;
+    if ((tokens->types[i] == TK_NONE) && ((tokens->values[i] < 0) || (tokens->values[i] > LAST_LEXICAL_ERROR)))
+      return 0;
+  }
+
+  symbols = (int*) malloc((symbolCount + 1) * sizeof(int));
+  name = names;
+  for (i = 0; i < symbolCount; i++) {
+    length = strlen(name);
+    symbols[i] = internName(ctx->interner, name, length);
+    if (symbols[i] != i)
+      renumber = 1;
+    name += length + 1;
+  }
+  if (renumber)
+    for (i = 0; i < tokens->count; i++)
+      if (tokens->types[i] == TK_IDENT)
+	tokens->values[i] = symbols[tokens->values[i]];
+  free(symbols);
+  return 1;
+}
+
+// Returns the cached token stream of the current input, or NULL when
+// there is no cache file or it does not match the input
+TokenBuffer* loadTokenCache(KplContext *ctx, char *cacheName) {
+  struct TokenCacheHeader *header;
+  TokenBuffer *tokens = NULL;
+  struct stat st;
+  char *data, *p;
+  int fd = open(cacheName, O_RDONLY);
+  int count;
+
+  if (fd < 0)
+    return NULL;
+  if ((fstat(fd, &st) != 0) || (st.st_size < (off_t) sizeof(struct TokenCacheHeader))) {
+    close(fd);
+    return NULL;
+  }
+  data = (char*) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+
+  header = (struct TokenCacheHeader*) data;
+  if (validHeader(ctx, header, st.st_size)) {
+    count = header->tokenCount;
+    tokens = createTokenBuffer(count);
+    p = data + sizeof(struct TokenCacheHeader);
+    memcpy(tokens->offsets, p, count * sizeof(int32_t));
+    p += count * sizeof(int32_t);
+    memcpy(tokens->lengths, p, count * sizeof(int32_t));
+    p += count * sizeof(int32_t);
+    memcpy(tokens->values, p, count * sizeof(int32_t));
+    p += count * sizeof(int32_t);
+    memcpy(tokens->types, p, count * sizeof(uint8_t));
+    p += count * sizeof(uint8_t);
+    tokens->count = count;
+
+    if (!loadSymbols(ctx, tokens, p, header->namesSize, header->symbolCount)) {
+      freeTokenBuffer(tokens);
+      tokens = NULL;
+    }
+  }
+
+  munmap(data, st.st_size);
+  if (tokens != NULL)
+    ctx->tokenIndex = 0;
+  return tokens;
+}
+
+// Writes the cache next to its final name first and renames it, so that
+// a reader never sees half a file
+int saveTokenCache(KplContext *ctx, TokenBuffer *tokens, char *cacheName) {
+  struct TokenCacheHeader header;
+  Interner *interner = ctx->interner;
+  char *tempName = (char*) malloc(strlen(cacheName) + 32);
+  FILE *f;
+  int i, ok;
+
+  header.magic = TOKEN_CACHE_MAGIC;
+  header.version = TOKEN_CACHE_VERSION;
+  header.sourceSize = ctx->inputEnd - ctx->inputBuffer;
+  header.sourceHash = hashSource(ctx->inputBuffer, header.sourceSize);
+  header.tokenCount = tokens->count;
+  header.symbolCount = interner->symbolCount;
+  header.namesSize = 0;
+  for (i = 0; i < interner->symbolCount; i++)
+    header.namesSize += strlen(symbolName(interner, i)) + 1;
+
+  sprintf(tempName, "%s.%d.tmp", cacheName, (int) getpid());
+  f = fopen(tempName, "wb");
+  if (f == NULL) {
+    free(tempName);
+    return IO_ERROR;
+  }
+
+  ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+  ok = ok && (fwrite(tokens->offsets, sizeof(int32_t), tokens->count, f) == tokens->count);
+  ok = ok && (fwrite(tokens->lengths, sizeof(int32_t), tokens->count, f) == tokens->count);
+  ok = ok && (fwrite(tokens->values, sizeof(int32_t), tokens->count, f) == tokens->count);
+  ok = ok && (fwrite(tokens->types, sizeof(uint8_t), tokens->count, f) == tokens->count);
+  for (i = 0; ok && (i < interner->symbolCount); i++) {
+    char *name = symbolName(interner, i);
+    ok = (fwrite(name, 1, strlen(name) + 1, f) == strlen(name) + 1);
+  }
+
+  ok = (fclose(f) == 0) && ok;
+  ok = ok && (rename(tempName, cacheName) == 0);
+  if (!ok)
+    remove(tempName);
+  free(tempName);
+  return ok ? IO_SUCCESS : IO_ERROR;
+}
@@ -0,0 +1,49 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __TOKCACHE_H__
+#define __TOKCACHE_H__
+
+#include <stdint.h>
+#include "context.h"
+#include "tokenbuffer.h"
+
+// A .kpltok file holds the token stream of one source file, as written
+// by saveTokenCache:
+//
+//   header           struct TokenCacheHeader
+//   offsets          int32_t[tokenCount]
+//   lengths          int32_t[tokenCount]
+//   values           int32_t[tokenCount]
+//   types            uint8_t[tokenCount]
+//   names            namesSize bytes: the interner's names in symbol ID
+//                    order, each ending with '\0'
+//
+// in the byte order of the machine that wrote it. The file is only used
+// when its magic number, version and sizes are right and the size and
+// FNV-1a hash of the source are the ones it was made from. Change
+// TOKEN_CACHE_VERSION whenever the format or the token stream of the
+// scanner changes.
+
+#define TOKEN_CACHE_MAGIC 0x4B544F4Bu
+#define TOKEN_CACHE_VERSION 2
+#define TOKEN_CACHE_SUFFIX ".kpltok"
+
+struct TokenCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sourceHash;
+  uint32_t sourceSize;
+  uint32_t tokenCount;
+  uint32_t symbolCount;
+  uint32_t namesSize;
+};
+
+uint64_t hashSource(char *buffer, int size);
+TokenBuffer* loadTokenCache(KplContext *ctx, char *cacheName);
+int saveTokenCache(KplContext *ctx, TokenBuffer *tokens, char *cacheName);
+
+#endif
@@ -4,57 +4,36 @@
  * @version 1.0
  */
 
-#include <stdlib.h>
-#include <ctype.h>
 #include "token.h"
 
-struct {
-  char string[MAX_IDENT_LEN + 1];
-  TokenType tokenType;
-} keywords[KEYWORDS_COUNT] = {
-  {"PROGRAM", KW_PROGRAM},
-  {"CONST", KW_CONST},
-  {"TYPE", KW_TYPE},
-  {"VAR", KW_VAR},
-  {"INTEGER", KW_INTEGER},
-  {"CHAR", KW_CHAR},
-  {"ARRAY", KW_ARRAY},
-  {"OF", KW_OF},
-  {"FUNCTION", KW_FUNCTION},
-  {"PROCEDURE", KW_PROCEDURE},
-  {"BEGIN", KW_BEGIN},
-  {"END", KW_END},
-  {"CALL", KW_CALL},
-  {"IF", KW_IF},
-  {"THEN", KW_THEN},
-  {"ELSE", KW_ELSE},
-  {"WHILE", KW_WHILE},
-  {"DO", KW_DO},
-  {"FOR", KW_FOR},
-  {"TO", KW_TO}
-};
+// keywordTable, KW_HASH and the length bounds are generated by kwgen
+// from keywords.def
+#include "kwhash.h"
 
-int keywordEq(char *kw, char *string) {
-  while ((*kw != '\0') && (*string != '\0')) {
-    if (*kw != *string) break;
-    kw ++; string ++;
-  }
-  return ((*kw == '\0') && (*string == '\0'));
-}
-
-TokenType checkKeyword(char *string) {
+// A single probe of the perfect hash table and one compare. Keywords are
+// made of letters only, so clearing bit 5 is enough to fold the case.
+TokenType checkKeyword(char *string, int length) {
+  struct KeywordEntry *entry;
   int i;
-  for (i = 0; i < KEYWORDS_COUNT; i++)
-    if (keywordEq(keywords[i].string, string)) 
-      return keywords[i].tokenType;
-  return TK_NONE;
+
+  if ((length < KW_MIN_LEN) || (length > KW_MAX_LEN))
+    return TK_NONE;
+
+  entry = &keywordTable[KW_HASH(length, string[0] & 0xDF, string[length - 1] & 0xDF)];
+  if (entry->length != length)
+    return TK_NONE;
+  for (i = 0; i < length; i++)
+    if ((string[i] & 0xDF) != entry->string[i])
+      return TK_NONE;
+  return entry->tokenType;
 }
 
-Token* makeToken(TokenType tokenType, int lineNo, int colNo) {
-  Token *token = (Token*)malloc(sizeof(Token));
-  token->tokenType = tokenType;
-  token->lineNo = lineNo;
-  token->colNo = colNo;
+Token makeToken(TokenType tokenType, int offset, int value) {
+  Token token;
+
+  token.tokenType = tokenType;
+  token.offset = offset;
+  token.value = value;
   return token;
 }
 
@@ -7,9 +7,6 @@
 #ifndef __TOKEN_H__
 #define __TOKEN_H__
 
-#define MAX_IDENT_LEN 15
-#define KEYWORDS_COUNT 20
-
 typedef enum {
   TK_NONE, TK_IDENT, TK_NUMBER, TK_CHAR, TK_EOF,
 
@@ -26,15 +23,28 @@ typedef enum {
   SB_LPAR, SB_RPAR, SB_LSEL, SB_RSEL
 } TokenType; 
 
+// A token is a 12-byte value, passed and stored by copy. It does not own
+// its lexeme: the lexeme starts at offset in the source buffer and its
+// line and column are recovered from the line index of the reader when
+// needed. value holds the number of a TK_NUMBER, the character of a
+// TK_CHAR and the symbol ID of a TK_IDENT. The length is not kept: right
+// after a scan it is where the reader stopped, see scannedLength().
 typedef struct {
-  char string[MAX_IDENT_LEN + 1];
-  int lineNo, colNo;
-  TokenType tokenType;
+  unsigned char tokenType;
+  int offset;
   int value;
 } Token;
 
-TokenType checkKeyword(char *string);
-Token* makeToken(TokenType tokenType, int lineNo, int colNo);
+// A set of token types as a bitmask, which works because there are fewer
+// than 64 of them. The FIRST and FOLLOW sets of the grammar rules are
+// generated in this form into gramsets.h.
+typedef unsigned long long TokenSet;
+
+#define TOKEN_BIT(tokenType) (((TokenSet) 1) << (tokenType))
+#define IN_SET(set, tokenType) (((set) & TOKEN_BIT(tokenType)) != 0)
+
+TokenType checkKeyword(char *string, int length);
+Token makeToken(TokenType tokenType, int offset, int value);
 char *tokenToString(TokenType tokenType);
 
 
@@ -0,0 +1,118 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+#include "scanner.h"
+#include "tokenbuffer.h"
+#include "error.h"
+
+#define MIN_TOKEN_CAPACITY 64
+
+void growTokenBuffer(TokenBuffer *buffer, int capacity) {
+  buffer->types = (unsigned char*) realloc(buffer->types, capacity * sizeof(unsigned char));
+  buffer->offsets = (int*) realloc(buffer->offsets, capacity * sizeof(int));
+  buffer->lengths = (int*) realloc(buffer->lengths, capacity * sizeof(int));
+  buffer->values = (int*) realloc(buffer->values, capacity * sizeof(int));
+  buffer->capacity = capacity;
+}
+
+TokenBuffer* createTokenBuffer(int capacity) {
+  TokenBuffer *buffer = (TokenBuffer*) calloc(1, sizeof(TokenBuffer));
+
+  growTokenBuffer(buffer, (capacity < MIN_TOKEN_CAPACITY) ? MIN_TOKEN_CAPACITY : capacity);
+  return buffer;
+}
+
+void appendToken(TokenBuffer *buffer, TokenType tokenType, int offset, int length, int value) {
+  int i = buffer->count;
+
+  if (i == buffer->capacity)
+    growTokenBuffer(buffer, 2 * buffer->capacity);
+  buffer->types[i] = tokenType;
+  buffer->offsets[i] = offset;
+  buffer->lengths[i] = length;
+  buffer->values[i] = value;
+  buffer->count ++;
+}
+
+// Scans the input from the current position to its end. Lexical errors
+// are recorded instead of reported: error() jumps back here and the
+// error entry ends the stream.
+TokenBuffer* tokenizeInput(KplContext *ctx) {
+  TokenBuffer *buffer = createTokenBuffer((ctx->inputEnd - ctx->inputPtr) / 4);
+  jmp_buf outerJump;
+  Token token;
+
+  memcpy(outerJump, ctx->errorJump, sizeof(jmp_buf));
+  ctx->recordErrors = 1;
+  if (setjmp(ctx->errorJump) == 0) {
+    do {
+      token = nextToken(ctx);
+      appendToken(buffer, token.tokenType, token.offset, scannedLength(ctx, token), token.value);
+    } while (token.tokenType != TK_EOF);
+  } else appendToken(buffer, TK_NONE, ctx->errorOffset, 0, ctx->errorCode);
+  ctx->recordErrors = 0;
+  memcpy(ctx->errorJump, outerJump, sizeof(jmp_buf));
+
+  ctx->tokenIndex = 0;
+  return buffer;
+}
+
+// Scans one token into the given fields, with ctx->recordErrors set. A
+// lexical error is returned as a TK_NONE token whose value is the error
+// code.
+void scanOne(KplContext *ctx, TokenType *tokenType, int *offset, int *length, int *value) {
+  Token token;
+
+  if (setjmp(ctx->errorJump) != 0) {
+    *tokenType = TK_NONE;
+    *offset = ctx->errorOffset;
+    *length = 0;
+    *value = ctx->errorCode;
+    return;
+  }
+  token = nextToken(ctx);
+  *tokenType = token.tokenType;
+  *offset = token.offset;
+  *length = scannedLength(ctx, token);
+  *value = token.value;
+}
+
+void freeTokenBuffer(TokenBuffer *buffer) {
+  if (buffer == NULL)
+    return;
+  free(buffer->types);
+  free(buffer->offsets);
+  free(buffer->lengths);
+  free(buffer->values);
+  free(buffer);
+}
+
+// The buffered counterpart of getValidToken(). The stream always ends
+// with TK_EOF or an error entry, and the parser stops at either, so the
+// index never runs past the end.
+Token nextBufferedToken(KplContext *ctx) {
+  TokenBuffer *buffer = ctx->tokens;
+  int i = ctx->tokenIndex ++;
+
+  if (buffer->types[i] == TK_NONE)
+    error(ctx, buffer->values[i], buffer->offsets[i]);
+  return makeToken(buffer->types[i], buffer->offsets[i], buffer->values[i]);
+}
+
+// The type of the token distance places after the lookahead (0 is the
+// lookahead itself), TK_EOF past the end of the stream
+TokenType peekTokenType(KplContext *ctx, int distance) {
+  TokenBuffer *buffer = ctx->tokens;
+  int i = ctx->tokenIndex - 1 + distance;
+
+  if (i >= buffer->count)
+    return TK_EOF;
+  return buffer->types[i];
+}
@@ -0,0 +1,39 @@
+/* 
+ * @copyright (c) 2008, Hedspi, Hanoi University of Technology
+ * @author Huu-Duc Nguyen
+ * @version 1.0
+ */
+
+#ifndef __TOKENBUFFER_H__
+#define __TOKENBUFFER_H__
+
+#include "context.h"
+#include "token.h"
+
+// The token stream of a whole file, scanned up front and kept as one
+// array per field. TK_NONE never occurs in a scanned stream, so an entry
+// of that type marks a lexical error: its value is the ErrorCode, raised
+// when the parser gets there, just where the lazy scanner would have
+// raised it.
+struct TokenBuffer_ {
+  unsigned char *types;
+  int *offsets;
+  int *lengths;
+  int *values;
+  int count;
+  int capacity;
+};
+
+typedef struct TokenBuffer_ TokenBuffer;
+
+TokenBuffer* createTokenBuffer(int capacity);
+void growTokenBuffer(TokenBuffer *buffer, int capacity);
+void appendToken(TokenBuffer *buffer, TokenType tokenType, int offset, int length, int value);
+TokenBuffer* tokenizeInput(KplContext *ctx);
+void scanOne(KplContext *ctx, TokenType *tokenType, int *offset, int *length, int *value);
+void freeTokenBuffer(TokenBuffer *buffer);
+
+Token nextBufferedToken(KplContext *ctx);
+TokenType peekTokenType(KplContext *ctx, int distance);
+
+#endif